@@ -0,0 +1,408 @@
+// Maze benchmark
+// Headless timings of the game's hot paths, written as CSV or JSON so runs can be
+// compared in CI:
+//   generate   Maze construction at each difficulty's cell size, for several maze sizes
+//              (variant regenerate: rebuilding a pooled maze of the same size in place)
+//   algorithm  every registered generator on one large grid (throughput and peak heap)
+//   collision  random Maze::isWall queries
+//   agents     simulation ticks of a 100k bot crowd on a giant maze, on one thread and on a pool
+//   kernels    whole-grid wall scans (wall count, dead ends, halving) on a 16M-cell maze,
+//              through the wall kernels and cell by cell, and the difficulty metrics of that maze
+//   pathfind   random point-to-point queries over 16x16 chunks of an endless maze, distances
+//              only and full paths (variant chunks: adding the chunks with their portal graphs)
+//   draw       Maze::draw() per frame in a hidden window, for both render modes (--draw only)
+//
+// Usage: maze_bench [--format csv|json] [--mazes N] [--draw] [--out file]
+// Maze n of a configuration always uses seed n, so runs are reproducible.
+
+#include "raylib.h"
+#include "maze.h"
+#include "agent_swarm.h"
+#include "chunk_pathfinder.h"
+#include "wall_mip_chain.h"
+#include "maze_generators.h"
+#include "rng.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// Heap accounting: every allocation carries a small header with its size, so the
+// current and peak number of live bytes can be tracked across a generation run.
+// Atomic because the agents suite frees pool tasks on worker threads.
+static std::atomic<size_t> liveBytes(0);
+static std::atomic<size_t> peakBytes(0);
+
+void *operator new(size_t size) {
+    size_t *block = (size_t *)malloc(size + sizeof(max_align_t));
+    if (!block) throw std::bad_alloc();
+    *block = size;
+    size_t live = liveBytes += size;
+    if (live > peakBytes) peakBytes = live;
+    return (char *)block + sizeof(max_align_t);
+}
+
+// Kept out of line: inlined into a sized delete, GCC flags the free() of the header as a
+// mismatched deallocation of what operator new returned
+__attribute__((noinline)) void operator delete(void *ptr) noexcept {
+    if (!ptr) return;
+    size_t *block = (size_t *)((char *)ptr - sizeof(max_align_t));
+    liveBytes -= *block;
+    free(block);
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+
+// Sized deletes, which compilers may call instead, free through the header like the others
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { operator delete(ptr); }
+
+// Reference screen the difficulty sizes are derived from, like the game does at 1080p
+const int SCREEN_WIDTH = 1920;
+const int SCREEN_HEIGHT = 1080;
+const int CELL_SIZES[] = {50, 40, 30};   // Facile, Moyen, Difficile
+const int SIZE_FACTORS[] = {1, 2, 6, 16}; // Screens per maze side (6 = Geant)
+const int COLLISION_QUERIES = 1 << 20;
+const int SWARM_AGENTS = 100000;
+const int SWARM_TICKS = 60;               // Ticks per sample, one second of simulation
+const int PATH_CHUNKS = 16;               // Chunks per side of the region searched by the pathfinder
+const int PATH_QUERIES = 200;
+
+static volatile long long querySink = 0; // Consumes query results so they are not optimized away
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One line of output
+struct Result {
+    std::string benchmark;               // generate, algorithm, collision, agents, kernels or draw
+    std::string variant;                 // Algorithm, render mode or threading
+    int cellSize, width, height;         // Maze configuration
+    int iterations;                      // Samples taken
+    double meanMs, minMs;                // Time per sample
+    double throughput;                   // Work units per second (cells, queries, agent steps, chunks or frames)
+    size_t peakBytes;                    // Peak heap during a sample (generation only)
+};
+
+// Running min/mean over the samples of one configuration
+struct Timer {
+    double total = 0.0, best = 0.0;
+    int samples = 0;
+
+    void add(double seconds) {
+        if (samples == 0 || seconds < best) best = seconds;
+        total += seconds;
+        samples++;
+    }
+};
+
+static Result makeResult(const char *benchmark, const char *variant, int cellSize, int width, int height,
+                         const Timer &timer, double unitsPerSample, size_t peak) {
+    double mean = timer.total / timer.samples;
+    return {benchmark, variant, cellSize, width, height, timer.samples, mean * 1e3, timer.best * 1e3,
+            unitsPerSample / mean, peak};
+}
+
+static void writeCsv(FILE *out, const std::vector<Result> &results) {
+    fprintf(out, "benchmark,variant,cell_size,width,height,iterations,mean_ms,min_ms,throughput_per_s,peak_bytes\n");
+    for (const Result &r : results) {
+        fprintf(out, "%s,%s,%d,%d,%d,%d,%.4f,%.4f,%.1f,%zu\n", r.benchmark.c_str(), r.variant.c_str(), r.cellSize,
+                r.width, r.height, r.iterations, r.meanMs, r.minMs, r.throughput, r.peakBytes);
+    }
+}
+
+static void writeJson(FILE *out, const std::vector<Result> &results) {
+    fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(out, "  {\"benchmark\": \"%s\", \"variant\": \"%s\", \"cell_size\": %d, \"width\": %d, \"height\": %d, "
+                     "\"iterations\": %d, \"mean_ms\": %.4f, \"min_ms\": %.4f, \"throughput_per_s\": %.1f, "
+                     "\"peak_bytes\": %zu}%s\n",
+                r.benchmark.c_str(), r.variant.c_str(), r.cellSize, r.width, r.height, r.iterations, r.meanMs,
+                r.minMs, r.throughput, r.peakBytes, (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+// Generation at every difficulty and size, plus collision queries on the generated mazes
+static void benchmarkGeneration(std::vector<Result> &results, int mazes) {
+    for (int cellSize : CELL_SIZES) {
+        for (int factor : SIZE_FACTORS) {
+            int width = SCREEN_WIDTH / cellSize * factor, height = SCREEN_HEIGHT / cellSize * factor;
+            Timer generation, regeneration, collision;
+            size_t peak = 0, regenerationPeak = 0;
+            long long openCells = 0;
+
+            for (int n = 0; n < mazes; n++) {
+                size_t baseline = liveBytes;
+                peakBytes = liveBytes.load();
+                auto start = std::chrono::steady_clock::now();
+                Maze maze(width, height, cellSize, BLACK, Texture2D{}, (uint64_t)n);
+                generation.add(secondsSince(start));
+                peak = std::max(peak, peakBytes - baseline);
+
+                // What the level pool does when the same difficulty is played again
+                baseline = liveBytes;
+                peakBytes = liveBytes.load();
+                start = std::chrono::steady_clock::now();
+                maze.regenerate(width, height, cellSize, BLACK, (uint64_t)(n + mazes));
+                regeneration.add(secondsSince(start));
+                regenerationPeak = std::max(regenerationPeak, peakBytes - baseline);
+
+                Rng rng((uint64_t)n);
+                std::vector<int> xs(COLLISION_QUERIES), ys(COLLISION_QUERIES);
+                for (int q = 0; q < COLLISION_QUERIES; q++) {
+                    xs[q] = (int)rng.below(width);
+                    ys[q] = (int)rng.below(height);
+                }
+                start = std::chrono::steady_clock::now();
+                for (int q = 0; q < COLLISION_QUERIES; q++) openCells += !maze.isWall(xs[q], ys[q]);
+                collision.add(secondsSince(start));
+            }
+
+            results.push_back(makeResult("generate", "dfs", cellSize, width, height, generation,
+                                         (double)width * height, peak));
+            results.push_back(makeResult("generate", "regenerate", cellSize, width, height, regeneration,
+                                         (double)width * height, regenerationPeak));
+            querySink = querySink + openCells;
+            results.push_back(makeResult("collision", "isWall", cellSize, width, height, collision,
+                                         COLLISION_QUERIES, 0));
+        }
+    }
+}
+
+// Every registered algorithm on one large grid
+static void benchmarkAlgorithms(std::vector<Result> &results, int mazes) {
+    const int width = 2049, height = 2049;
+    for (int a = 0; a < MAZE_ALGORITHM_COUNT; a++) {
+        const MazeGeneratorEntry &entry = getMazeGenerators()[a];
+        Timer timer;
+        size_t peak = 0;
+        for (int n = 0; n < mazes; n++) {
+            size_t baseline = liveBytes;
+            peakBytes = liveBytes.load();
+            auto start = std::chrono::steady_clock::now();
+            WallGrid grid(width, height);
+            Rng rng((uint64_t)n);
+            entry.create()->generate(grid, rng);
+            timer.add(secondsSince(start));
+            peak = std::max(peak, peakBytes - baseline);
+        }
+        results.push_back(makeResult("algorithm", entry.name, 1, width, height, timer, (double)width * height, peak));
+    }
+}
+
+// Crowd ticks on a giant Difficile maze, every agent stepping every tick (no cooldown)
+static void benchmarkAgents(std::vector<Result> &results, int mazes) {
+    const int cellSize = CELL_SIZES[2], width = SCREEN_WIDTH / cellSize * 6, height = SCREEN_HEIGHT / cellSize * 6;
+    ThreadPool pool;
+    const char *variants[] = {"serial", "pool"};
+    for (int v = 0; v < 2; v++) {
+        Timer timer;
+        for (int n = 0; n < mazes; n++) {
+            Maze maze(width, height, cellSize, BLACK, Texture2D{}, (uint64_t)n);
+            AgentSwarm swarm(maze.getGrid(), 0);
+            swarm.spawn(SWARM_AGENTS, (uint64_t)n);
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < SWARM_TICKS; t++) swarm.tick(v == 1 ? &pool : nullptr);
+            timer.add(secondsSince(start) / SWARM_TICKS);
+        }
+        results.push_back(makeResult("agents", variants[v], cellSize, width, height, timer, (double)SWARM_AGENTS, 0));
+    }
+}
+
+// Whole-grid scans through the packed-word kernels and the same scans one get() per cell.
+// Throughput is in cells per second.
+static void benchmarkKernels(std::vector<Result> &results, int mazes) {
+    const int width = 4097, height = 4097;
+    const char *names[] = {"walls", "walls-cells", "dead-ends", "dead-ends-cells", "reduce", "reduce-cells", "metrics"};
+    Timer timers[7];
+    for (int n = 0; n < mazes; n++) {
+        WallGrid grid(width, height);
+        Rng rng((uint64_t)n);
+        getMazeGenerators()[0].create()->generate(grid, rng);
+        long long sink = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        sink += (long long)countWalls(grid);
+        timers[0].add(secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) sink += grid.get(x, y);
+        }
+        timers[1].add(secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        sink += (long long)countDeadEnds(grid);
+        timers[2].add(secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (grid.get(x, y)) continue;
+                int open = (x > 0 && !grid.get(x - 1, y)) + (x + 1 < width && !grid.get(x + 1, y)) +
+                           (y > 0 && !grid.get(x, y - 1)) + (y + 1 < height && !grid.get(x, y + 1));
+                sink += open == 1;
+            }
+        }
+        timers[3].add(secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        WallGrid half = downsampleWalls(grid);
+        timers[4].add(secondsSince(start));
+        sink += half.data()[0] & 1;
+
+        start = std::chrono::steady_clock::now();
+        WallGrid naive(half.getWidth(), half.getHeight());
+        for (int y = 0; y < naive.getHeight(); y++) {
+            for (int x = 0; x < naive.getWidth(); x++) {
+                // Open if any of the cells it stands for on the lattice is
+                bool open = false;
+                for (int dy = (y & 1) ? -1 : 0; dy <= ((y & 1) ? 1 : 0); dy += 2) {
+                    for (int dx = (x & 1) ? -1 : 0; dx <= ((x & 1) ? 1 : 0); dx += 2) {
+                        int cx = 2 * x + dx, cy = 2 * y + dy;
+                        open = open || (grid.isInside(cx, cy) && !grid.get(cx, cy));
+                    }
+                }
+                if (open) naive.clearWall(x, y);
+            }
+        }
+        timers[5].add(secondsSince(start));
+        sink += naive.data()[0] & 1;
+
+        DistanceField exitDistances;
+        exitDistances.build(grid, width - 2, height - 2);
+        start = std::chrono::steady_clock::now();
+        sink += measureMaze(grid, exitDistances, 1, 1).solutionDecisions;
+        timers[6].add(secondsSince(start));
+        querySink = querySink + sink;
+    }
+    for (int k = 0; k < 7; k++) {
+        results.push_back(makeResult("kernels", names[k], 1, width, height, timers[k], (double)width * height, 0));
+    }
+}
+
+// Hierarchical queries between random open cells of a region of an endless maze.
+// Throughput is in chunks or queries per second.
+static void benchmarkPathfinder(std::vector<Result> &results, int mazes) {
+    const int side = PATH_CHUNKS * CHUNK_SIZE;
+    Timer chunkTimer, distanceTimer, pathTimer;
+    for (int n = 0; n < mazes; n++) {
+        ChunkedMaze maze(1, BLACK, SpriteFrame{}, (uint64_t)n, PATH_CHUNKS - 1);
+        ChunkPathfinder paths;
+        auto start = std::chrono::steady_clock::now();
+        paths.addChunks(maze, 0, 0, PATH_CHUNKS - 1, PATH_CHUNKS - 1);
+        chunkTimer.add(secondsSince(start));
+
+        // Odd coordinates are always carved passages
+        Rng rng((uint64_t)n);
+        std::vector<PathCell> ends(2 * PATH_QUERIES);
+        for (PathCell &cell : ends) cell = {2 * (int)rng.below(side / 2) + 1, 2 * (int)rng.below(side / 2) + 1};
+        ChunkPathScratch scratch;
+        std::vector<PathCell> path;
+        long long sink = 0;
+
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < PATH_QUERIES; q++) {
+            sink += paths.distance(ends[2 * q].x, ends[2 * q].y, ends[2 * q + 1].x, ends[2 * q + 1].y, scratch);
+        }
+        distanceTimer.add(secondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < PATH_QUERIES; q++) {
+            paths.findPath(ends[2 * q].x, ends[2 * q].y, ends[2 * q + 1].x, ends[2 * q + 1].y, path, scratch);
+            sink += (long long)path.size();
+        }
+        pathTimer.add(secondsSince(start));
+        querySink = querySink + sink;
+    }
+    results.push_back(makeResult("pathfind", "chunks", 1, side, side, chunkTimer, (double)PATH_CHUNKS * PATH_CHUNKS, 0));
+    results.push_back(makeResult("pathfind", "distance", 1, side, side, distanceTimer, (double)PATH_QUERIES, 0));
+    results.push_back(makeResult("pathfind", "path", 1, side, side, pathTimer, (double)PATH_QUERIES, 0));
+}
+
+// Frame time of Maze::draw() in both render modes, drawn through a screen-sized view like the game
+static void benchmarkDraw(std::vector<Result> &results, int mazes) {
+    const int frames = 120;
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "maze_bench");
+    SetTargetFPS(0); // Never wait between frames
+
+    for (int cellSize : CELL_SIZES) {
+        for (int factor : SIZE_FACTORS) {
+            int width = SCREEN_WIDTH / cellSize * factor, height = SCREEN_HEIGHT / cellSize * factor;
+            const MazeRenderMode modes[] = {MazeRenderMode::Texture, MazeRenderMode::Rectangles};
+            const char *modeNames[] = {"texture", "rectangles"};
+
+            for (int m = 0; m < 2; m++) {
+                Timer timer;
+                for (int n = 0; n < mazes; n++) {
+                    Maze maze(width, height, cellSize, DARKGRAY, Texture2D{}, (uint64_t)n);
+                    maze.setRenderMode(modes[m]);
+                    maze.bakeWalls();
+
+                    // Centered screen-sized view, as the camera sees a giant maze mid-level
+                    Rectangle view = {(width * cellSize - SCREEN_WIDTH) / 2.0f, (height * cellSize - SCREEN_HEIGHT) / 2.0f,
+                                      (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT};
+                    Camera2D camera = {};
+                    camera.target = {view.x, view.y};
+                    camera.zoom = 1.0f;
+
+                    auto start = std::chrono::steady_clock::now();
+                    for (int f = 0; f < frames; f++) {
+                        BeginDrawing();
+                        ClearBackground(RAYWHITE);
+                        BeginMode2D(camera);
+                        maze.draw(view);
+                        EndMode2D();
+                        EndDrawing();
+                    }
+                    timer.add(secondsSince(start) / frames);
+                }
+                results.push_back(makeResult("draw", modeNames[m], cellSize, width, height, timer, 1.0, 0));
+            }
+        }
+    }
+    CloseWindow();
+}
+
+int main(int argc, char **argv) {
+    bool json = false, draw = false;
+    int mazes = 5;
+    const char *outPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) json = strcmp(argv[++i], "json") == 0;
+        else if (strcmp(argv[i], "--mazes") == 0 && i + 1 < argc) mazes = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--draw") == 0) draw = true;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--format csv|json] [--mazes N] [--draw] [--out file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    benchmarkGeneration(results, mazes);
+    benchmarkAlgorithms(results, mazes);
+    benchmarkAgents(results, mazes);
+    benchmarkKernels(results, mazes);
+    benchmarkPathfinder(results, mazes);
+    if (draw) benchmarkDraw(results, mazes);
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", outPath);
+        return 1;
+    }
+    if (json) writeJson(out, results);
+    else writeCsv(out, results);
+    if (outPath) fclose(out);
+    return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef AGENT_SWARM_H
+#define AGENT_SWARM_H
+
+#include "raylib.h"
+#include "rng.h"
+#include "sprite_instancer.h"
+#include "thread_pool.h"
+#include "wall_grid.h"
+#include "wall_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Agents of the smallest share of the crowd a pool thread steps
+const int AGENT_BLOCK = 256;
+
+// AgentSwarm class definition
+// Crowd of autonomous walkers wandering through a wall grid. Agents are stored as
+// structure of arrays of 32-bit values and stepped CELL_LANES at a time with the
+// lanes of wall_kernels.h (8 with AVX2, 4 with NEON): pick a target cell, gather its
+// wall bit from the packed grid, commit the move, all branch-free with lane masks.
+// Shares of whole blocks are spread over a thread pool. Every agent has its own
+// random state, so the crowd moves the same whatever the number of threads or lanes.
+class AgentSwarm {
+private:
+    const WallGrid &grid;                // Walls the agents walk in, must outlive the swarm
+    int moveCooldown;                    // Ticks between two moves of an agent
+
+    std::vector<int32_t> x, y;           // Agent positions in cells
+    std::vector<uint32_t> heading;       // 0 up, 1 down, 2 left, 3 right
+    std::vector<uint32_t> cooldown;      // Ticks left before the agent may move
+    std::vector<uint32_t> rngState;      // xorshift32 state of each agent, never 0
+    mutable std::vector<Vector2> visible; // Pixel positions of the agents drawn this frame
+
+    template <class Lanes>
+    static Lanes load(const void *values) {
+        Lanes lanes;
+        memcpy(&lanes, values, sizeof(lanes));
+        return lanes;
+    }
+
+    template <class Lanes>
+    static void store(void *values, Lanes lanes) {
+        memcpy(values, &lanes, sizeof(lanes));
+    }
+
+    // Mask of the lanes that hold 0 (all ones), for values below 2^31
+    template <class Lanes>
+    static Lanes zeroMask(Lanes values) {
+        return 0 - ((values - 1) >> 31);
+    }
+
+    // Steps the agents from first on, as many as Lanes holds: a group of CellLanes or a single
+    // uint32_t. Positions wrap around as unsigned values, which the wall lookup sees as outside.
+    template <class Lanes>
+    void stepLanes(size_t first) {
+        Lanes px = load<Lanes>(&x[first]), py = load<Lanes>(&y[first]);
+        Lanes direction = load<Lanes>(&heading[first]), wait = load<Lanes>(&cooldown[first]);
+        Lanes random = load<Lanes>(&rngState[first]);
+
+        // xorshift32, then a new heading about one tick in 16
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        Lanes turn = zeroMask<Lanes>(random & 15);
+        direction = (turn & ((random >> 4) & 3)) | (~turn & direction);
+
+        // Target cell: up and down (headings 0 and 1) move on y, left and right on x, odd ones forward
+        Lanes sign = ((direction & 1) << 1) - 1, horizontal = 0 - (direction >> 1);
+        Lanes tx = px + (sign & horizontal), ty = py + (sign & ~horizontal);
+        Lanes blocked = wallBitAt(grid, tx, ty);
+
+        // Agents off cooldown move, or pick a new heading when facing a wall
+        Lanes ready = zeroMask<Lanes>(wait);
+        Lanes moves = ready & (blocked - 1), stuck = ready & (0 - blocked);
+        px = (moves & tx) | (~moves & px);
+        py = (moves & ty) | (~moves & py);
+        direction = (stuck & ((random >> 8) & 3)) | (~stuck & direction);
+        wait = (ready & (uint32_t)moveCooldown) | (~ready & (wait - 1));
+
+        store(&x[first], px);
+        store(&y[first], py);
+        store(&heading[first], direction);
+        store(&cooldown[first], wait);
+        store(&rngState[first], random);
+    }
+
+    // Steps the agents in [begin, end), whole groups of lanes then the rest one by one
+    void stepRange(size_t begin, size_t end) {
+        size_t i = begin;
+        for (; i + CELL_LANES <= end; i += CELL_LANES) stepLanes<CellLanes>(i);
+        for (; i < end; i++) stepLanes<uint32_t>(i);
+    }
+
+public:
+    // Creates an empty swarm walking the given grid
+    AgentSwarm(const WallGrid &walls, int cooldownTicks)
+        : grid(walls), moveCooldown(std::min(std::max(cooldownTicks, 0), 255)) {}
+
+    // Places count agents on random open passage cells
+    void spawn(size_t count, uint64_t seed) {
+        Rng rng(seed);
+        int columns = grid.getWidth() / 2, rows = grid.getHeight() / 2;
+        if (columns == 0 || rows == 0) return;
+        for (size_t i = 0; i < count; i++) {
+            int cx = 2 * (int)rng.below(columns) + 1, cy = 2 * (int)rng.below(rows) + 1;
+            if (grid.get(cx, cy)) continue; // Not every lattice cell is carved in a loaded maze
+            x.push_back(cx);
+            y.push_back(cy);
+            heading.push_back(rng.below(4));
+            cooldown.push_back(rng.below(moveCooldown + 1)); // Spread the moves over the ticks
+            rngState.push_back((uint32_t)rng.next() | 1);
+        }
+    }
+
+    // Removes every agent
+    void clear() {
+        x.clear();
+        y.clear();
+        heading.clear();
+        cooldown.clear();
+        rngState.clear();
+    }
+
+    // Advances every agent by one simulation tick, on the pool's threads if one is given
+    void tick(ThreadPool *pool = nullptr) {
+        size_t count = x.size();
+        if (!pool || count < 4 * (size_t)AGENT_BLOCK) {
+            stepRange(0, count);
+            return;
+        }
+        // Whole blocks per thread
+        size_t blocks = (count + AGENT_BLOCK - 1) / AGENT_BLOCK;
+        pool->parallelFor(blocks, [&](size_t first, size_t last) {
+            stepRange(first * AGENT_BLOCK, std::min(count, last * AGENT_BLOCK));
+        });
+    }
+
+    // Draws the agents inside the given world-space rectangle, one instance of the sprite each,
+    // scaled to the cell width like the player
+    void draw(Rectangle view, int cellSize, const SpriteFrame &sprite, Color tint, SpriteInstancer &instancer) const {
+        int x0 = (int)std::floor(view.x / cellSize), y0 = (int)std::floor(view.y / cellSize);
+        int x1 = (int)std::ceil((view.x + view.width) / cellSize), y1 = (int)std::ceil((view.y + view.height) / cellSize);
+        visible.clear();
+        for (size_t i = 0; i < x.size(); i++) {
+            if (x[i] < x0 || x[i] >= x1 || y[i] < y0 || y[i] >= y1) continue;
+            visible.push_back({(float)(x[i] * cellSize), (float)(y[i] * cellSize)});
+        }
+        if (sprite.source.width <= 0) return;
+        Vector2 size = {(float)cellSize, sprite.source.height * cellSize / sprite.source.width};
+        instancer.draw(sprite, visible.data(), visible.size(), size, tint);
+    }
+
+    size_t size() const { return x.size(); }
+    int getX(size_t i) const { return x[i]; }
+    int getY(size_t i) const { return y[i]; }
+};
+
+#endif // AGENT_SWARM_H
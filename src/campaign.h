@@ -0,0 +1,77 @@
+#ifndef CAMPAIGN_H
+#define CAMPAIGN_H
+
+#include "raylib.h"
+#include "level_generator.h"
+#include "maze.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Campaign class definition
+// Endless sequence of levels, each with a seed derived from the campaign seed and
+// its number, so a campaign seed always plays the same levels (e.g. for leaderboards).
+// The next `lookahead` levels are generated ahead on a thread pool, and every level
+// handed to the game immediately schedules the one `lookahead` places after it. Each
+// pending level has its own slot, which bounds the queue and keeps levels in order
+// however the workers finish.
+class Campaign {
+private:
+    std::function<LevelRequest(int)> levelRequest; // Dimensions and difficulty of level n
+    uint64_t seed;                       // Campaign seed every level seed derives from
+    int lookahead;                       // Levels generated ahead of the one being played
+    std::unique_ptr<std::atomic<GeneratedLevel *>[]> slots; // Level n waits in slot n % lookahead
+    int nextLevel;                       // Number of the next level handed to the game
+    LevelPool &levels;                   // Where the levels are built and the unplayed ones go back
+    ThreadPool pool;                     // Workers generating the levels
+
+    // Starts generating level n into its slot, which the game has already emptied
+    void schedule(int level) {
+        LevelRequest request = levelRequest(level);
+        request.seed = mixSeed(seed ^ (uint64_t)level);
+        std::atomic<GeneratedLevel *> *slot = &slots[level % lookahead];
+        LevelPool *levelPool = &levels;
+        pool.submit([request, slot, levelPool] {
+            slot->store(levelPool->build(request), std::memory_order_release);
+        });
+    }
+
+public:
+    // Starts generating the first `levelsAhead` levels right away. The pool must outlive the campaign.
+    Campaign(std::function<LevelRequest(int)> requestForLevel, uint64_t campaignSeed, int levelsAhead, LevelPool &levelPool)
+        : levelRequest(requestForLevel), seed(campaignSeed), lookahead(std::max(1, levelsAhead)),
+          slots(new std::atomic<GeneratedLevel *>[std::max(1, levelsAhead)]), nextLevel(0), levels(levelPool) {
+        for (int i = 0; i < lookahead; i++) slots[i].store(nullptr);
+        for (int i = 0; i < lookahead; i++) schedule(i);
+    }
+
+    // Destructor to stop the workers and hand back the levels nobody played
+    ~Campaign() {
+        pool.shutdown(); // Waits for the levels being generated, the queued ones never start
+        for (int i = 0; i < lookahead; i++) {
+            GeneratedLevel *level = slots[i].exchange(nullptr);
+            if (level) levels.recycle(level);
+        }
+    }
+
+    Campaign(const Campaign &) = delete;
+    Campaign &operator=(const Campaign &) = delete;
+
+    // Takes the next level if it is ready, or returns nullptr. The caller owns the
+    // returned level and its maze until it hands it back to the pool. Never blocks.
+    GeneratedLevel *take() {
+        GeneratedLevel *level = slots[nextLevel % lookahead].exchange(nullptr, std::memory_order_acq_rel);
+        if (level) {
+            schedule(nextLevel + lookahead);
+            nextLevel++;
+        }
+        return level;
+    }
+
+    // Number of levels handed to the game so far
+    int getLevelsPlayed() const { return nextLevel; }
+};
+
+#endif // CAMPAIGN_H
@@ -0,0 +1,268 @@
+#ifndef CHUNK_PATHFINDER_H
+#define CHUNK_PATHFINDER_H
+
+#include "chunked_maze.h"
+#include "distance_field.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Abstract graph nodes of the start and goal cells of a query, beside the portal nodes
+const uint64_t PATH_START_NODE = ~0ULL;
+const uint64_t PATH_GOAL_NODE = ~0ULL - 1;
+
+// One cell of a path, in maze coordinates
+struct PathCell {
+    int x, y;
+};
+
+// Buffers of a pathfinder query. Queries only read the pathfinder, so each thread
+// running them keeps one of these and nothing else is shared.
+class ChunkPathScratch {
+private:
+    friend class ChunkPathfinder;
+
+    // A node of the abstract graph reached by the search
+    struct Node {
+        uint32_t cost;                   // Best walking distance from the start found so far
+        uint64_t parent;                 // Node it was reached from
+        bool closed;                     // Whether its cost is final
+    };
+
+    // Open list entry, ordered by estimated total cost
+    struct Open {
+        uint32_t estimate;
+        uint64_t node;
+        bool operator>(const Open &other) const { return estimate > other.estimate; }
+    };
+
+    std::unordered_map<uint64_t, Node> nodes; // Nodes reached by the current query
+    std::vector<Open> open;              // Binary min-heap on estimate
+    std::vector<PathCell> waypoints;     // Start, portal cells, goal: the abstract path
+    DistanceField fromStart, toGoal;     // Searches inside the start and goal chunks
+    DistanceField segment;               // Search of the segment being refined
+};
+
+// ChunkPathfinder class definition
+// Point-to-point paths over a ChunkedMaze, hierarchical like HPA*. Each chunk comes
+// with its portal graph (the cells facing its openings and the walking distances
+// between them inside the chunk, computed when it is generated), and the portals of
+// all chunks form a small abstract graph: four nodes per chunk instead of 4096 cells.
+// A query searches the start and goal chunks cell by cell, runs A* over the portals,
+// then refines only the parts of the path it needs, one chunk at a time. The distances
+// are exact, so the paths are shortest paths.
+//
+// The pathfinder only knows the chunks added to it, and keeps them even once the maze
+// evicts them. Queries are const and read nothing but the immutable chunk data, so any
+// number of threads may run them at once without locks, as long as no chunk is added
+// meanwhile (add them between ticks, like ChunkedMaze::update generates its chunks).
+class ChunkPathfinder {
+private:
+    std::unordered_map<uint64_t, std::shared_ptr<const ChunkData>> chunks; // Chunks a path may cross
+
+    static uint64_t chunkKey(int cx, int cy) {
+        return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+    }
+
+    // Node of the portal on a side of a chunk (chunk coordinates below 2^30)
+    static uint64_t portalNode(int cx, int cy, int side) {
+        return ((uint64_t)cx << 32 | (uint64_t)cy << 2 | (uint64_t)side);
+    }
+
+    const ChunkData *findChunk(int cx, int cy) const {
+        if (cx < 0 || cy < 0) return nullptr;
+        auto found = chunks.find(chunkKey(cx, cy));
+        return found == chunks.end() ? nullptr : found->second.get();
+    }
+
+    const ChunkData *findCellChunk(int x, int y) const {
+        return (x < 0 || y < 0) ? nullptr : findChunk(x / CHUNK_SIZE, y / CHUNK_SIZE);
+    }
+
+    // Cell of a portal node, in maze coordinates
+    static PathCell portalCell(const ChunkData &chunk, int side) {
+        return {chunk.cx * CHUNK_SIZE + chunk.portals.x[side], chunk.cy * CHUNK_SIZE + chunk.portals.y[side]};
+    }
+
+    // Offers a node a path of the given cost, queuing it if the path is better
+    static void relax(ChunkPathScratch &scratch, uint64_t node, uint64_t parent, uint32_t cost, PathCell cell,
+                      PathCell goal) {
+        auto inserted = scratch.nodes.insert({node, {cost, parent, false}});
+        ChunkPathScratch::Node &record = inserted.first->second;
+        if (!inserted.second) {
+            if (record.closed || record.cost <= cost) return;
+            record.cost = cost;
+            record.parent = parent;
+        }
+        uint32_t remaining = (uint32_t)(std::abs(goal.x - cell.x) + std::abs(goal.y - cell.y)); // Never overestimates
+        scratch.open.push_back({cost + remaining, node});
+        std::push_heap(scratch.open.begin(), scratch.open.end(), std::greater<ChunkPathScratch::Open>());
+    }
+
+    // A* over the portals from (sx, sy) to (tx, ty). Leaves the abstract path in
+    // scratch.waypoints and returns its length, or UNREACHABLE.
+    uint32_t search(int sx, int sy, int tx, int ty, ChunkPathScratch &scratch) const {
+        scratch.nodes.clear();
+        scratch.open.clear();
+        scratch.waypoints.clear();
+        const ChunkData *startChunk = findCellChunk(sx, sy), *goalChunk = findCellChunk(tx, ty);
+        if (!startChunk || !goalChunk) return DistanceField::UNREACHABLE;
+        int startLocalX = sx - startChunk->cx * CHUNK_SIZE, startLocalY = sy - startChunk->cy * CHUNK_SIZE;
+        int goalLocalX = tx - goalChunk->cx * CHUNK_SIZE, goalLocalY = ty - goalChunk->cy * CHUNK_SIZE;
+        if (startChunk->walls.get(startLocalX, startLocalY) || goalChunk->walls.get(goalLocalX, goalLocalY)) {
+            return DistanceField::UNREACHABLE;
+        }
+        PathCell goal = {tx, ty};
+
+        // The start and goal chunks cell by cell: from the start to its portals (and maybe
+        // straight to the goal), and from the goal chunk's portals to the goal
+        scratch.fromStart.build(startChunk->walls, startLocalX, startLocalY);
+        scratch.toGoal.build(goalChunk->walls, goalLocalX, goalLocalY);
+        scratch.nodes[PATH_START_NODE] = {0, PATH_START_NODE, true};
+        for (int side = 0; side < CHUNK_SIDES; side++) {
+            if (!startChunk->portals.has(side)) continue;
+            uint32_t cost = scratch.fromStart.distance(startChunk->portals.x[side], startChunk->portals.y[side]);
+            if (cost == DistanceField::UNREACHABLE) continue;
+            relax(scratch, portalNode(startChunk->cx, startChunk->cy, side), PATH_START_NODE, cost,
+                  portalCell(*startChunk, side), goal);
+        }
+        if (startChunk == goalChunk) {
+            uint32_t direct = scratch.fromStart.distance(goalLocalX, goalLocalY);
+            if (direct != DistanceField::UNREACHABLE) {
+                relax(scratch, PATH_GOAL_NODE, PATH_START_NODE, direct, goal, goal);
+            }
+        }
+
+        static const int acrossX[CHUNK_SIDES] = {-1, 0, 1, 0};
+        static const int acrossY[CHUNK_SIDES] = {0, -1, 0, 1};
+        static const int facing[CHUNK_SIDES] = {CHUNK_RIGHT, CHUNK_BOTTOM, CHUNK_LEFT, CHUNK_TOP};
+        while (!scratch.open.empty()) {
+            std::pop_heap(scratch.open.begin(), scratch.open.end(), std::greater<ChunkPathScratch::Open>());
+            uint64_t node = scratch.open.back().node;
+            scratch.open.pop_back();
+            ChunkPathScratch::Node &record = scratch.nodes[node];
+            if (record.closed) continue; // Queued again with a better cost since
+            record.closed = true;
+            uint32_t cost = record.cost;
+            if (node == PATH_GOAL_NODE) break;
+
+            int cx = (int)(node >> 32), cy = (int)((node & 0xFFFFFFFFu) >> 2), side = (int)(node & 3);
+            const ChunkData &chunk = *findChunk(cx, cy);
+
+            // Across the border, one step into the neighbor if the pathfinder has it
+            const ChunkData *neighbor = findChunk(cx + acrossX[side], cy + acrossY[side]);
+            if (neighbor) {
+                relax(scratch, portalNode(neighbor->cx, neighbor->cy, facing[side]), node, cost + 1,
+                      portalCell(*neighbor, facing[side]), goal);
+            }
+            // To the other portals of the chunk
+            for (int to = 0; to < CHUNK_SIDES; to++) {
+                uint16_t steps = chunk.portals.distance[side][to];
+                if (to == side || steps == CHUNK_UNREACHABLE) continue;
+                relax(scratch, portalNode(cx, cy, to), node, cost + steps, portalCell(chunk, to), goal);
+            }
+            // To the goal, from the portals of its chunk
+            if (&chunk == goalChunk) {
+                uint32_t steps = scratch.toGoal.distance(chunk.portals.x[side], chunk.portals.y[side]);
+                if (steps != DistanceField::UNREACHABLE) relax(scratch, PATH_GOAL_NODE, node, cost + steps, goal, goal);
+            }
+        }
+
+        auto reached = scratch.nodes.find(PATH_GOAL_NODE);
+        if (reached == scratch.nodes.end() || !reached->second.closed) return DistanceField::UNREACHABLE;
+        for (uint64_t node = PATH_GOAL_NODE; node != PATH_START_NODE; node = scratch.nodes[node].parent) {
+            if (node == PATH_GOAL_NODE) {
+                scratch.waypoints.push_back(goal);
+            } else {
+                int cx = (int)(node >> 32), cy = (int)((node & 0xFFFFFFFFu) >> 2);
+                scratch.waypoints.push_back(portalCell(*findChunk(cx, cy), (int)(node & 3)));
+            }
+        }
+        scratch.waypoints.push_back({sx, sy});
+        std::reverse(scratch.waypoints.begin(), scratch.waypoints.end());
+        return reached->second.cost;
+    }
+
+    // Cells after from up to and including to, two waypoints of an abstract path: either
+    // facing portals (one step apart) or cells of the same chunk
+    void refine(PathCell from, PathCell to, ChunkPathScratch &scratch, std::vector<PathCell> &path) const {
+        if (from.x == to.x && from.y == to.y) return;
+        if (from.x / CHUNK_SIZE != to.x / CHUNK_SIZE || from.y / CHUNK_SIZE != to.y / CHUNK_SIZE) {
+            path.push_back(to);
+            return;
+        }
+        const ChunkData &chunk = *findCellChunk(to.x, to.y);
+        int originX = chunk.cx * CHUNK_SIZE, originY = chunk.cy * CHUNK_SIZE;
+        scratch.segment.build(chunk.walls, to.x - originX, to.y - originY);
+        int x = from.x - originX, y = from.y - originY, dx, dy;
+        while (scratch.segment.nextStep(x, y, dx, dy)) {
+            x += dx;
+            y += dy;
+            path.push_back({originX + x, originY + y});
+        }
+    }
+
+public:
+    // Makes a chunk available to the queries, generating it if the maze has not. Not while queries run.
+    void addChunk(const ChunkedMaze &maze, int cx, int cy) {
+        std::shared_ptr<const ChunkData> &chunk = chunks[chunkKey(cx, cy)];
+        if (!chunk) chunk = maze.getChunkData(cx, cy);
+    }
+
+    // Whether a chunk was added
+    bool hasChunk(int cx, int cy) const { return findChunk(cx, cy) != nullptr; }
+
+    // Adds every chunk of [cx0, cx1] x [cy0, cy1]
+    void addChunks(const ChunkedMaze &maze, int cx0, int cy0, int cx1, int cy1) {
+        for (int cy = std::max(0, cy0); cy <= cy1; cy++) {
+            for (int cx = std::max(0, cx0); cx <= cx1; cx++) addChunk(maze, cx, cy);
+        }
+    }
+
+    // Walking distance between two cells, UNREACHABLE if either is a wall or no path
+    // stays within the chunks added. Runs the abstract search only.
+    uint32_t distance(int sx, int sy, int tx, int ty, ChunkPathScratch &scratch) const {
+        return search(sx, sy, tx, ty, scratch);
+    }
+
+    // Cells of a shortest path from (sx, sy) to (tx, ty), the start excluded. Returns
+    // false, leaving path empty, if there is none.
+    bool findPath(int sx, int sy, int tx, int ty, std::vector<PathCell> &path, ChunkPathScratch &scratch) const {
+        path.clear();
+        if (search(sx, sy, tx, ty, scratch) == DistanceField::UNREACHABLE) return false;
+        for (size_t i = 0; i + 1 < scratch.waypoints.size(); i++) {
+            refine(scratch.waypoints[i], scratch.waypoints[i + 1], scratch, path);
+        }
+        return true;
+    }
+
+    // First move of a shortest path, refining only the stretch it starts. Returns false
+    // on the goal itself and when there is no path.
+    bool nextStep(int sx, int sy, int tx, int ty, int &dx, int &dy, ChunkPathScratch &scratch) const {
+        if (search(sx, sy, tx, ty, scratch) == DistanceField::UNREACHABLE) return false;
+        std::vector<PathCell> &waypoints = scratch.waypoints;
+        for (size_t i = 1; i < waypoints.size(); i++) {
+            if (waypoints[i].x == sx && waypoints[i].y == sy) continue; // The start is on a portal
+            PathCell next = waypoints[i];
+            if (std::abs(next.x - sx) + std::abs(next.y - sy) != 1) {
+                const ChunkData &chunk = *findCellChunk(sx, sy);
+                int originX = chunk.cx * CHUNK_SIZE, originY = chunk.cy * CHUNK_SIZE;
+                scratch.segment.build(chunk.walls, next.x - originX, next.y - originY);
+                return scratch.segment.nextStep(sx - originX, sy - originY, dx, dy);
+            }
+            dx = next.x - sx;
+            dy = next.y - sy;
+            return true;
+        }
+        return false;
+    }
+
+    // Number of chunks the queries can cross
+    size_t getChunkCount() const { return chunks.size(); }
+};
+
+#endif // CHUNK_PATHFINDER_H
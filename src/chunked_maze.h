@@ -0,0 +1,231 @@
+#ifndef CHUNKED_MAZE_H
+#define CHUNKED_MAZE_H
+
+#include "raylib.h"
+#include "distance_field.h"
+#include "maze.h"
+#include "maze_generators.h"
+#include "wall_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// Side of a chunk in cells. Even, so the passage lattice (odd coordinates) lines up across chunks.
+const int CHUNK_SIZE = 64;
+
+// Sides of a chunk, the index of its portals
+enum ChunkSide { CHUNK_LEFT, CHUNK_TOP, CHUNK_RIGHT, CHUNK_BOTTOM, CHUNK_SIDES };
+
+const uint16_t CHUNK_UNREACHABLE = 0xFFFF; // Portal distance between portals that do not connect
+
+// Ways in and out of a chunk: on each side, the cell of the chunk next to the opening
+// into the neighbor on that side, with the walking distances between them inside
+// the chunk. The cells of two facing portals are adjacent, one step apart.
+struct ChunkPortals {
+    int x[CHUNK_SIDES], y[CHUNK_SIDES];  // Local cell of each portal, x = -1 when the side has none
+    uint16_t distance[CHUNK_SIDES][CHUNK_SIDES]; // Steps inside the chunk between two portals
+
+    bool has(int side) const { return x[side] >= 0; }
+};
+
+// Everything generated for one chunk. It never changes afterwards, so the chunk cache
+// and a ChunkPathfinder share it and an evicted chunk lives on while a path needs it.
+struct ChunkData {
+    int cx, cy;                          // Chunk coordinates
+    WallGrid walls;                      // Wall plane of the chunk, local coordinates
+    std::vector<WallRect> rects;         // Greedy-merged walls used for drawing
+    ChunkPortals portals;                // Openings to the neighbors, computed with the walls
+
+    ChunkData(int x, int y) : cx(x), cy(y), walls(CHUNK_SIZE, CHUNK_SIZE), portals() {}
+};
+
+// ChunkedMaze class definition
+// Endless maze extending to the right and down from the origin, generated in
+// CHUNK_SIZE x CHUNK_SIZE chunks only when something looks at them. At most
+// maxChunks chunks stay in memory; the least recently used one is evicted first.
+//
+// Every chunk is a perfect maze grown from a seed derived from the world seed and
+// its coordinates, so an evicted chunk comes back identical. A chunk owns the wall
+// column on its left and the wall row on its top, and opens exactly one passage
+// through each of them at a position also derived from its seed. Seams therefore
+// match whatever order the chunks are generated in.
+class ChunkedMaze {
+private:
+    typedef std::shared_ptr<const ChunkData> Chunk; // One resident chunk of the maze
+
+    int cellSize;                        // Size of each cell in pixels
+    Color mazeColor;                     // Color of the maze walls
+    SpriteFrame exitSprite;              // Sprite to represent the exit point
+    uint64_t seed;                       // World seed every chunk seed derives from
+    MazeAlgorithm algorithm;             // Algorithm used to carve each chunk
+    size_t maxChunks;                    // Most chunks kept in memory at once
+    int exitX, exitY;                    // Coordinates for the exit location
+
+    // Chunk cache. Lookups are logically const, so the cache itself is mutable.
+    mutable std::list<Chunk> chunks;     // Resident chunks, most recently used first
+    mutable std::unordered_map<uint64_t, std::list<Chunk>::iterator> chunkIndex;
+    mutable const ChunkData *lastChunk;  // Last chunk looked up, skips the hash for runs of queries
+    mutable DistanceField portalSearch;  // Search from each portal of a new chunk, kept between chunks
+
+    static uint64_t chunkKey(int cx, int cy) {
+        return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+    }
+
+    // SplitMix64 finalizer over the world seed and the chunk coordinates
+    uint64_t chunkSeed(int cx, int cy) const {
+        uint64_t z = seed + chunkKey(cx, cy) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Row of the opening in the left border of a chunk, or column of the one in its top
+    // border: a passage row/column, so both sides of the border are carved. Chunks of
+    // the first column (row) have no left (top) opening.
+    int leftOpening(int cx, int cy) const {
+        return cx > 0 ? 2 * (int)((chunkSeed(cx, cy) >> 32) % (CHUNK_SIZE / 2)) + 1 : -1;
+    }
+    int topOpening(int cx, int cy) const {
+        return cy > 0 ? 2 * (int)((chunkSeed(cx, cy) >> 48) % (CHUNK_SIZE / 2)) + 1 : -1;
+    }
+
+    // Finds the portals of a carved chunk: its own openings, and the cells facing the
+    // openings of its right and bottom neighbors (known from their seeds alone)
+    void findPortals(ChunkData &chunk) const {
+        ChunkPortals &portals = chunk.portals;
+        int left = leftOpening(chunk.cx, chunk.cy), top = topOpening(chunk.cx, chunk.cy);
+        int right = leftOpening(chunk.cx + 1, chunk.cy), bottom = topOpening(chunk.cx, chunk.cy + 1);
+        portals.x[CHUNK_LEFT] = left >= 0 ? 0 : -1;
+        portals.y[CHUNK_LEFT] = left;
+        portals.x[CHUNK_TOP] = top;
+        portals.y[CHUNK_TOP] = 0;
+        portals.x[CHUNK_RIGHT] = CHUNK_SIZE - 1;
+        portals.y[CHUNK_RIGHT] = right;
+        portals.x[CHUNK_BOTTOM] = bottom;
+        portals.y[CHUNK_BOTTOM] = CHUNK_SIZE - 1;
+
+        for (int from = 0; from < CHUNK_SIDES; from++) {
+            for (int to = 0; to < CHUNK_SIDES; to++) portals.distance[from][to] = CHUNK_UNREACHABLE;
+            if (!portals.has(from)) continue;
+            portalSearch.build(chunk.walls, portals.x[from], portals.y[from]);
+            for (int to = 0; to < CHUNK_SIDES; to++) {
+                if (!portals.has(to)) continue;
+                uint32_t steps = portalSearch.distance(portals.x[to], portals.y[to]);
+                if (steps != DistanceField::UNREACHABLE) portals.distance[from][to] = (uint16_t)steps;
+            }
+        }
+    }
+
+    // Carves a chunk from its own seed, then opens its left and top borders
+    Chunk generateChunk(int cx, int cy) const {
+        std::shared_ptr<ChunkData> chunk = std::make_shared<ChunkData>(cx, cy);
+        Rng rng(chunkSeed(cx, cy));
+        createMazeGenerator(algorithm)->generate(chunk->walls, rng);
+
+        // One opening on each shared border
+        int left = leftOpening(cx, cy), top = topOpening(cx, cy);
+        if (left >= 0) chunk->walls.clearWall(0, left);
+        if (top >= 0) chunk->walls.clearWall(top, 0);
+
+        mergeWallRects(chunk->walls, chunk->rects);
+        findPortals(*chunk);
+        return chunk;
+    }
+
+    // Returns a chunk, generating it if needed and marking it as most recently used
+    const Chunk &getChunk(int cx, int cy) const {
+        if (lastChunk && lastChunk->cx == cx && lastChunk->cy == cy) return chunks.front(); // Already at the front
+
+        uint64_t key = chunkKey(cx, cy);
+        auto found = chunkIndex.find(key);
+        if (found != chunkIndex.end()) {
+            chunks.splice(chunks.begin(), chunks, found->second);
+        } else {
+            chunks.push_front(generateChunk(cx, cy));
+            chunkIndex[key] = chunks.begin();
+
+            // Evict from the back, never the chunk just generated
+            while (chunks.size() > maxChunks) {
+                chunkIndex.erase(chunkKey(chunks.back()->cx, chunks.back()->cy));
+                chunks.pop_back();
+            }
+        }
+        lastChunk = chunks.front().get();
+        return chunks.front();
+    }
+
+public:
+    // Constructor for the ChunkedMaze class. The exit sits exitChunks chunks right and down from the start.
+    ChunkedMaze(int size, Color color, SpriteFrame exitFrame, uint64_t worldSeed, int exitChunks = 8,
+                size_t chunkLimit = 64, MazeAlgorithm algo = MazeAlgorithm::DFS)
+        : cellSize(size), mazeColor(color), exitSprite(exitFrame), seed(worldSeed), algorithm(algo),
+          maxChunks(std::max<size_t>(chunkLimit, 9)), lastChunk(nullptr) {
+        // Odd local coordinates are always carved passages
+        exitX = exitChunks * CHUNK_SIZE + CHUNK_SIZE / 2 + 1;
+        exitY = exitChunks * CHUNK_SIZE + CHUNK_SIZE / 2 + 1;
+    }
+
+    // Checks if a given cell is a wall, generating its chunk on demand
+    bool isWall(int x, int y) const {
+        if (x < 0 || y < 0) return true; // The maze only extends right and down
+        const ChunkData &chunk = *getChunk(x / CHUNK_SIZE, y / CHUNK_SIZE);
+        return chunk.walls.get(x % CHUNK_SIZE, y % CHUNK_SIZE);
+    }
+
+    // Checks if the given coordinates are at the exit position
+    bool isExit(int x, int y) const {
+        return x == exitX && y == exitY;
+    }
+
+    // Generates the chunks around the player ahead of time, so walking into them never stalls
+    void update(int playerX, int playerY) {
+        int pcx = playerX / CHUNK_SIZE, pcy = playerY / CHUNK_SIZE;
+        for (int cy = std::max(0, pcy - 1); cy <= pcy + 1; cy++) {
+            for (int cx = std::max(0, pcx - 1); cx <= pcx + 1; cx++) {
+                getChunk(cx, cy);
+            }
+        }
+        getChunk(pcx, pcy); // Keep the player's own chunk the most recently used
+    }
+
+    // Draws the part of the maze inside the given world-space rectangle
+    void draw(Rectangle view) const {
+        int x0 = std::max(0, (int)std::floor(view.x / cellSize));
+        int y0 = std::max(0, (int)std::floor(view.y / cellSize));
+        int x1 = (int)std::ceil((view.x + view.width) / cellSize);
+        int y1 = (int)std::ceil((view.y + view.height) / cellSize);
+
+        for (int cy = y0 / CHUNK_SIZE; cy * CHUNK_SIZE < y1; cy++) {
+            for (int cx = x0 / CHUNK_SIZE; cx * CHUNK_SIZE < x1; cx++) {
+                const ChunkData &chunk = *getChunk(cx, cy);
+                int originX = cx * CHUNK_SIZE, originY = cy * CHUNK_SIZE;
+                drawWallRects(chunk.rects, originX, originY, cellSize, mazeColor,
+                              x0 - originX, y0 - originY, x1 - originX, y1 - originY);
+            }
+        }
+
+        // Draw the exit texture at the exit position
+        Vector2 exitPosition = {(float)(exitX * cellSize), (float)(exitY * cellSize)};
+        drawSpriteScaled(exitSprite, exitPosition, (float)cellSize, WHITE);
+    }
+
+    // Shared, immutable data of a chunk, generating it if needed. It stays valid after the
+    // chunk is evicted from the cache, for as long as it is held. A chunk generated here
+    // does not enter the cache, so far-away queries never evict the chunks around the player.
+    std::shared_ptr<const ChunkData> getChunkData(int cx, int cy) const {
+        auto found = chunkIndex.find(chunkKey(cx, cy));
+        return found != chunkIndex.end() ? *found->second : generateChunk(cx, cy);
+    }
+
+    int getCellSize() const { return cellSize; }
+    int getExitX() const { return exitX; }
+    int getExitY() const { return exitY; }
+
+    // Number of chunks currently held in memory
+    size_t getResidentChunkCount() const { return chunks.size(); }
+};
+
+#endif // CHUNKED_MAZE_H
@@ -0,0 +1,105 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "wall_grid.h"
+#include "wall_kernels.h"
+#include <cstdint>
+#include <vector>
+
+// DistanceField class definition
+// Walking distance from every open cell of a wall grid to one target cell, computed
+// once with a breadth-first search. Afterwards the remaining distance and the next
+// step toward the target are O(1) lookups. Distances are stored in 16 bits when the
+// maze has few enough open cells for every distance to fit, in 32 bits otherwise.
+class DistanceField {
+public:
+    static const uint32_t UNREACHABLE = 0xFFFFFFFFu; // Distance of walls and cells cut off from the target
+
+private:
+    int width, height;                   // Dimensions of the grid the field was built from
+    std::vector<uint16_t> narrow;        // Distances when they all fit in 16 bits
+    std::vector<uint32_t> wide;          // Distances otherwise (only one of the two is used)
+    std::vector<int> queue;              // Search queue, kept so rebuilding a same-size field does not allocate
+
+    // Breadth-first search from the target over the open cells
+    template <typename Distance>
+    static void search(const WallGrid &grid, int targetX, int targetY, std::vector<Distance> &distances,
+                       std::vector<int> &queue) {
+        const Distance unreached = (Distance)~(Distance)0;
+        int w = grid.getWidth(), h = grid.getHeight();
+        distances.assign((size_t)w * h, unreached);
+        if (!grid.isInside(targetX, targetY) || grid.get(targetX, targetY)) return;
+
+        static const int steps[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+        queue.clear();                   // Cell indices in the order they are reached
+        queue.reserve((size_t)w * h / 2 + 1);
+        distances[(size_t)targetY * w + targetX] = 0;
+        queue.push_back(targetY * w + targetX);
+
+        for (size_t head = 0; head < queue.size(); head++) {
+            int cell = queue[head];
+            int x = cell % w, y = cell / w;
+            Distance next = distances[cell] + 1;
+            for (const auto &step : steps) {
+                int nx = x + step[0], ny = y + step[1];
+                if (!grid.isInside(nx, ny) || grid.get(nx, ny)) continue;
+                int neighbour = ny * w + nx;
+                if (distances[neighbour] != unreached) continue;
+                distances[neighbour] = next;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+
+public:
+    DistanceField() : width(0), height(0) {}
+
+    // Computes the distance of every cell to (targetX, targetY), reusing the buffers of the previous build
+    void build(const WallGrid &grid, int targetX, int targetY) {
+        width = grid.getWidth();
+        height = grid.getHeight();
+
+        // No path is longer than the number of open cells minus one
+        size_t openCells = (size_t)width * height - countWalls(grid);
+
+        if (openCells < 0xFFFF) {
+            wide.clear();
+            wide.shrink_to_fit();
+            search(grid, targetX, targetY, narrow, queue);
+        } else {
+            narrow.clear();
+            narrow.shrink_to_fit();
+            search(grid, targetX, targetY, wide, queue);
+        }
+    }
+
+    // Number of steps from a cell to the target, UNREACHABLE for walls and cut-off cells
+    uint32_t distance(int x, int y) const {
+        if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) return UNREACHABLE;
+        size_t cell = (size_t)y * width + x;
+        if (!narrow.empty()) return narrow[cell] == 0xFFFF ? UNREACHABLE : narrow[cell];
+        return wide.empty() ? UNREACHABLE : wide[cell];
+    }
+
+    // Finds the neighbouring cell one step closer to the target.
+    // Returns false on the target itself and on cells that cannot reach it.
+    bool nextStep(int x, int y, int &dx, int &dy) const {
+        uint32_t current = distance(x, y);
+        if (current == 0 || current == UNREACHABLE) return false;
+
+        static const int steps[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+        for (const auto &step : steps) {
+            if (distance(x + step[0], y + step[1]) == current - 1) {
+                dx = step[0];
+                dy = step[1];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number of bytes used by the distances
+    size_t byteSize() const { return narrow.size() * sizeof(uint16_t) + wide.size() * sizeof(uint32_t); }
+};
+
+#endif // DISTANCE_FIELD_H
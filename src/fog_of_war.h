@@ -0,0 +1,157 @@
+#ifndef FOG_OF_WAR_H
+#define FOG_OF_WAR_H
+
+#include "raylib.h"
+#include "wall_grid.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Fog over a cell never seen, seen before but out of sight, and in sight
+const Color FOG_UNSEEN = {0, 0, 0, 255};
+const Color FOG_REMEMBERED = {0, 0, 0, 150};
+const Color FOG_IN_SIGHT = {0, 0, 0, 0};
+
+// FogOfWar class definition
+// What the player has seen of a maze. Cells in sight are the straight corridor runs
+// from the player's cell up to the first wall, with the walls lining them; once seen
+// a cell stays revealed, dimmed while out of sight. Nothing is recomputed unless the
+// player moves, and then only the runs around the old and the new position change.
+//
+// The fog is drawn from a texture holding one texel per cell, stretched over the
+// maze. The texels live in CPU memory too, and each frame uploads only the
+// rectangle that changed since the previous one.
+class FogOfWar {
+private:
+    const WallGrid &grid;                // Walls that block the sight, must outlive the fog
+    int width, height, stride;           // Dimensions in cells, 64-bit words per row of seenBits
+    std::vector<uint64_t> seenBits;      // 1 bit per cell, 1 = seen at least once
+    std::vector<int> visible;            // Indices of the cells in sight from the last position
+    int lastX, lastY;                    // Position sight was last computed from, -1 before the first
+
+    std::vector<Color> texels;           // Fog color of every cell, row by row
+    std::vector<Color> upload;           // Dirty rectangle packed for the upload
+    Texture2D texture;                   // texels on the GPU, id 0 until the first draw
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1; // Cells changed since the last upload, empty when x0 >= x1
+
+    bool isSeen(int x, int y) const {
+        return (seenBits[(size_t)y * stride + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    void markDirty(int x, int y) {
+        dirtyX0 = std::min(dirtyX0, x);
+        dirtyY0 = std::min(dirtyY0, y);
+        dirtyX1 = std::max(dirtyX1, x + 1);
+        dirtyY1 = std::max(dirtyY1, y + 1);
+    }
+
+    void setTexel(int x, int y, Color color) {
+        Color &texel = texels[(size_t)y * width + x];
+        if (texel.a == color.a) return;
+        texel = color;
+        markDirty(x, y);
+    }
+
+    // Puts a cell in sight and remembers it
+    void see(int x, int y) {
+        if (!grid.isInside(x, y)) return;
+        seenBits[(size_t)y * stride + (x >> 6)] |= 1ULL << (x & 63);
+        visible.push_back(y * width + x);
+        setTexel(x, y, FOG_IN_SIGHT);
+    }
+
+public:
+    // Creates a fog covering the whole grid
+    explicit FogOfWar(const WallGrid &walls)
+        : grid(walls), width(walls.getWidth()), height(walls.getHeight()), stride((walls.getWidth() + 63) / 64),
+          seenBits((size_t)stride * walls.getHeight(), 0), lastX(-1), lastY(-1),
+          texels((size_t)walls.getWidth() * walls.getHeight(), FOG_UNSEEN), texture(), dirtyX0(0), dirtyY0(0),
+          dirtyX1(walls.getWidth()), dirtyY1(walls.getHeight()) {}
+
+    ~FogOfWar() { unloadTexture(); }
+
+    // The texture is owned by a single fog
+    FogOfWar(const FogOfWar &) = delete;
+    FogOfWar &operator=(const FogOfWar &) = delete;
+
+    // Covers the whole grid again, keeping the buffers (the walls may have changed, not their size)
+    void reset() {
+        std::fill(seenBits.begin(), seenBits.end(), 0);
+        std::fill(texels.begin(), texels.end(), FOG_UNSEEN);
+        visible.clear();
+        lastX = lastY = -1;
+        dirtyX0 = dirtyY0 = 0;
+        dirtyX1 = width;
+        dirtyY1 = height;
+    }
+
+    // Releases the texture, the next draw uploads every texel again
+    void unloadTexture() {
+        if (texture.id != 0) UnloadTexture(texture);
+        texture = Texture2D();
+    }
+
+    // Recomputes what is in sight from the given cell. Returns false, doing nothing, if it did not change.
+    bool update(int x, int y) {
+        if (x == lastX && y == lastY) return false;
+        lastX = x;
+        lastY = y;
+
+        // What was in sight is only remembered now, unless it is seen again below
+        for (int index : visible) setTexel(index % width, index / width, FOG_REMEMBERED);
+        visible.clear();
+
+        // The cell itself and its neighbours, corners included
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            for (int nx = x - 1; nx <= x + 1; nx++) see(nx, ny);
+        }
+        // Each corridor run with the cells on both sides of it, up to and including the wall ending it
+        static const int stepX[4] = {1, -1, 0, 0};
+        static const int stepY[4] = {0, 0, 1, -1};
+        for (int d = 0; d < 4; d++) {
+            int cx = x, cy = y;
+            while (true) {
+                cx += stepX[d];
+                cy += stepY[d];
+                if (!grid.isInside(cx, cy)) break;
+                see(cx, cy);
+                if (grid.get(cx, cy)) break;
+                see(cx + stepY[d], cy + stepX[d]);
+                see(cx - stepY[d], cy - stepX[d]);
+            }
+        }
+        return true;
+    }
+
+    // Whether a cell was ever in sight
+    bool wasSeen(int x, int y) const {
+        return grid.isInside(x, y) && isSeen(x, y);
+    }
+
+    // Draws the fog over the cell range [x0, x1) x [y0, y1), uploading the texels
+    // changed since the last draw first. Needs a window.
+    void draw(int x0, int y0, int x1, int y1, int cellSize) {
+        if (texture.id == 0) {
+            Image image = {texels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+            texture = LoadTextureFromImage(image); // Copies the texels, the image is not owned
+        } else if (dirtyX0 < dirtyX1 && dirtyY0 < dirtyY1) {
+            int rectWidth = dirtyX1 - dirtyX0, rectHeight = dirtyY1 - dirtyY0;
+            upload.resize((size_t)rectWidth * rectHeight);
+            for (int y = 0; y < rectHeight; y++) {
+                std::copy_n(&texels[(size_t)(dirtyY0 + y) * width + dirtyX0], rectWidth, &upload[(size_t)y * rectWidth]);
+            }
+            UpdateTextureRec(texture, {(float)dirtyX0, (float)dirtyY0, (float)rectWidth, (float)rectHeight}, upload.data());
+        }
+        dirtyX0 = width;
+        dirtyY0 = height;
+        dirtyX1 = dirtyY1 = 0;
+
+        // One texel per cell, filtered as points so every cell keeps sharp edges
+        Rectangle source = {(float)x0, (float)y0, (float)(x1 - x0), (float)(y1 - y0)};
+        Rectangle dest = {(float)(x0 * cellSize), (float)(y0 * cellSize), (float)((x1 - x0) * cellSize),
+                          (float)((y1 - y0) * cellSize)};
+        DrawTexturePro(texture, source, dest, {0, 0}, 0.0f, WHITE);
+    }
+};
+
+#endif // FOG_OF_WAR_H
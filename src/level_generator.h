@@ -0,0 +1,225 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include "raylib.h"
+#include "maze.h"
+#include "rng.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Everything needed to build one level's maze
+struct LevelRequest {
+    int difficulty;                      // Menu difficulty the level was generated for
+    int width, height, cellSize;         // Maze dimensions and size of each cell
+    Color color;                         // Color of the maze walls
+    uint64_t seed;                       // Seed of the generation
+    float minTortuosity;                 // Mazes whose solution winds less than this are generated again, 0 for any
+    int maxCandidates;                   // Mazes generated at most before keeping the hardest one
+};
+
+// A finished level waiting in the mailbox
+struct GeneratedLevel {
+    LevelRequest request;                // What the maze was built from
+    Maze *maze;                          // Generated maze, owned by whoever takes the level
+
+    // Candidates of the rejection sampling, kept so that the next level built reuses them
+    WallGrid candidateWalls{0, 0}, bestWalls{0, 0};
+    DistanceField candidateDistances{}, bestDistances{}; // Exit distances of the walls beside them
+};
+
+// LevelPool class definition
+// Recycles finished levels, so playing level after level never frees or allocates a
+// maze: a level handed back keeps its Maze, and the next level built rewrites that
+// maze in place, reusing its wall, distance and fog buffers when the dimensions match
+// (every time a difficulty is replayed). Shared by the generator threads and the game.
+class LevelPool {
+private:
+    std::mutex mutex;                    // Guards freeLevels
+    std::vector<GeneratedLevel *> freeLevels; // Levels handed back, their mazes ready to be rewritten
+
+    // How much the solution of a maze carved by Maze::carveWalls winds, from the start cell to its exit
+    static float tortuosity(const WallGrid &walls, const DistanceField &exitDistances) {
+        return measureMaze(walls, exitDistances, 1, 1).tortuosity(1, 1, walls.getWidth() - 2, walls.getHeight() - 2);
+    }
+
+public:
+    LevelPool() { freeLevels.reserve(16); } // More than the levels ever in flight at once
+
+    // Deletes the pooled levels. Their textures were released when they were handed back.
+    ~LevelPool() {
+        for (GeneratedLevel *level : freeLevels) {
+            delete level->maze;
+            delete level;
+        }
+    }
+
+    LevelPool(const LevelPool &) = delete;
+    LevelPool &operator=(const LevelPool &) = delete;
+
+    // Builds the maze of a request into a pooled level, preferring one of the same dimensions.
+    // Mazes too easy for the request are rejected and carved again from derived seeds until
+    // one is hard enough or maxCandidates were tried; the hardest one is kept then. Candidates
+    // are only carved and measured, the kept one alone gets its mip chain and rectangles.
+    // Only allocates when the pool is empty. The caller owns the level until it is handed back.
+    GeneratedLevel *build(const LevelRequest &request) {
+        GeneratedLevel *level = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeLevels.empty()) {
+                size_t pick = freeLevels.size() - 1;
+                for (size_t i = 0; i < freeLevels.size(); i++) {
+                    const Maze *maze = freeLevels[i]->maze;
+                    if (maze->getWidth() == request.width && maze->getHeight() == request.height) pick = i;
+                }
+                level = freeLevels[pick];
+                freeLevels[pick] = freeLevels.back();
+                freeLevels.pop_back();
+            }
+        }
+        if (request.minTortuosity <= 0) {
+            if (!level) {
+                Maze *maze = new Maze(request.width, request.height, request.cellSize, request.color, Texture2D{},
+                                      request.seed);
+                return new GeneratedLevel{request, maze};
+            }
+            level->request = request;
+            level->maze->regenerate(request.width, request.height, request.cellSize, request.color, request.seed);
+            return level;
+        }
+        if (!level) level = new GeneratedLevel{request, nullptr};
+        level->request = request;
+
+        // Rejection sampling on bare walls: the derived seeds keep a request's level reproducible
+        uint64_t bestSeed = request.seed;
+        float best = -1.0f;
+        for (int candidate = 0; candidate < std::max(1, request.maxCandidates) && best < request.minTortuosity;
+             candidate++) {
+            uint64_t seed = candidate == 0 ? request.seed : mixSeed(request.seed + (uint64_t)candidate);
+            WallGrid &walls = level->candidateWalls;
+            if (walls.getWidth() == request.width && walls.getHeight() == request.height && !walls.isExternal()) {
+                walls.fillWalls();
+            } else {
+                walls = WallGrid(request.width, request.height); // Also when a loaded maze handed over its file
+            }
+            Maze::carveWalls(walls, seed, MazeAlgorithm::DFS);
+            level->candidateDistances.build(walls, request.width - 2, request.height - 2);
+            float score = tortuosity(walls, level->candidateDistances);
+            if (score > best) {
+                best = score;
+                bestSeed = seed;
+                std::swap(level->candidateWalls, level->bestWalls);
+                std::swap(level->candidateDistances, level->bestDistances);
+            }
+        }
+        if (level->maze) {
+            level->maze->adoptWalls(level->bestWalls, level->bestDistances, request.cellSize, request.color, bestSeed);
+        } else {
+            level->maze = new Maze(std::move(level->bestWalls), request.width - 2, request.height - 2, request.cellSize,
+                                   request.color, Texture2D{}, bestSeed);
+            level->bestWalls = WallGrid(0, 0); // Its buffer went to the maze
+        }
+        return level;
+    }
+
+    // Hands a level back. Its maze must hold no texture: the game releases them first, and the
+    // mazes of levels never played were never drawn.
+    void recycle(GeneratedLevel *level) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeLevels.push_back(level);
+    }
+};
+
+// LevelGenerator class definition
+// Builds mazes on a worker thread so the render loop never waits on generation.
+// The game thread posts requests (e.g. as soon as a difficulty is highlighted in
+// the menu) and collects results from a single-slot mailbox: a lock-free atomic
+// pointer exchange that always holds the most recent level. The worker only
+// takes a lock to sleep while it has nothing to do.
+class LevelGenerator {
+private:
+    std::thread worker;                  // Thread running the generation loop
+    std::mutex requestMutex;             // Guards pending, requestTicket and stopping
+    std::condition_variable wake;        // Wakes the worker when a request arrives
+    LevelRequest pending;                // Latest request posted by the game thread
+    uint32_t requestTicket;              // Incremented for every request
+    std::atomic<uint32_t> latestTicket;  // Copy of requestTicket the worker can read without locking
+    bool stopping;                       // Set when the generator is destroyed
+
+    std::atomic<GeneratedLevel *> mailbox; // Single-slot handoff to the game thread
+    LevelPool &pool;                     // Where the levels come from and unwanted ones go back
+
+    // Generation loop: wait for a request, build it, publish it unless superseded
+    void run() {
+        uint32_t servedTicket = 0;
+        while (true) {
+            LevelRequest request;
+            uint32_t ticket;
+            {
+                std::unique_lock<std::mutex> lock(requestMutex);
+                wake.wait(lock, [&] { return stopping || requestTicket != servedTicket; });
+                if (stopping) return;
+                request = pending;
+                ticket = servedTicket = requestTicket;
+            }
+
+            GeneratedLevel *level = pool.build(request);
+
+            // A newer request arrived while generating: this level is no longer wanted
+            if (ticket != latestTicket.load(std::memory_order_acquire)) {
+                pool.recycle(level);
+                continue;
+            }
+
+            // Publish, replacing any level the game never collected
+            GeneratedLevel *previous = mailbox.exchange(level, std::memory_order_acq_rel);
+            if (previous) pool.recycle(previous);
+        }
+    }
+
+public:
+    // The pool must outlive the generator
+    explicit LevelGenerator(LevelPool &levelPool)
+        : pending(), requestTicket(0), latestTicket(0), stopping(false), mailbox(nullptr), pool(levelPool) {
+        worker = std::thread(&LevelGenerator::run, this);
+    }
+
+    // Destructor to stop the worker and hand back any level left in the mailbox
+    ~LevelGenerator() {
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+
+        GeneratedLevel *level = mailbox.exchange(nullptr);
+        if (level) pool.recycle(level);
+    }
+
+    LevelGenerator(const LevelGenerator &) = delete;
+    LevelGenerator &operator=(const LevelGenerator &) = delete;
+
+    // Asks for a new level. Supersedes every earlier request that has not been delivered yet.
+    void request(const LevelRequest &levelRequest) {
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            pending = levelRequest;
+            requestTicket++;
+            latestTicket.store(requestTicket, std::memory_order_release);
+        }
+        wake.notify_one();
+    }
+
+    // Takes the finished level out of the mailbox, or returns nullptr if none is ready.
+    // The caller owns the returned level and its maze until it hands it back to the pool. Never blocks.
+    GeneratedLevel *take() {
+        return mailbox.exchange(nullptr, std::memory_order_acq_rel);
+    }
+};
+
+#endif // LEVEL_GENERATOR_H
@@ -1,359 +1,958 @@
 #include "raylib.h"
+#include "maze.h"
+#include "agent_swarm.h"
+#include "music_player.h"
+#include "player.h"
+#include "chunked_maze.h"
+#include "chunk_pathfinder.h"
+#include "level_generator.h"
+#include "campaign.h"
+#include "profiler.h"
+#include "race_session.h"
+#include "replay.h"
+#include "sprite_atlas.h"
+#include "sprite_instancer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#if defined(PLATFORM_WEB)
+#include <emscripten/emscripten.h>
+#endif
+
+// The game logic runs in fixed ticks, independent of the frame rate
+const int SIMULATION_RATE = 60;                       // Simulation ticks per second
+const double SIMULATION_TICK = 1.0 / SIMULATION_RATE; // Duration of a tick in seconds
+const int MAX_TICKS_PER_FRAME = 8;                    // After a stall, the rest of the backlog is dropped
+const int REPLAY_FAST_FORWARD = 8;                    // Simulation speed of a replay while TAB is held
 
-// Cell class definition
-// Class representing a single cell in the maze
-class Cell {
-public:
-    bool isWall;   // Indicates whether the cell is a wall
-    bool visited;  // Indicates whether the cell has been visited during maze generation
-
-    // Constructor to initialize a cell as a wall and unvisited by default
-    Cell() : isWall(true), visited(false) {}
-};
+// Function to handle menu selection logic with keyboard input
+int choix(int selectedButton, int nmbrButton) {
+    // Move selection down
+    if (IsKeyPressed(KEY_DOWN)) {
+        selectedButton = (selectedButton + 1) % nmbrButton; // Wrap to the first button when exceeding the number of buttons
+    }
+    // Move selection up
+    if (IsKeyPressed(KEY_UP)) {
+        selectedButton = (selectedButton - 1 + nmbrButton) % nmbrButton; // Wrap to the last button when going below the first one
+    }
+    return selectedButton; // Return the updated selection index
+}
 
-// Maze class definition
-class Maze {
-private:
-    int width, height, cellSize;         // Dimensions of the maze and size of each cell
-    Cell** grid;                         // 2D array to represent the maze grid
-    int exitX, exitY;                    // Coordinates for the exit location
-    Color mazeColor;                     // Color of the maze walls
-    Texture2D exitTexture;               // Texture to represent the exit point
-
-    // Checks if the given coordinates are inside the maze boundaries
-    bool isInsideGrid(int x, int y) const {
-        return x >= 0 && x < width && y >= 0 && y < height;
+// Function to handle character selection logic with keyboard input
+int choix2(int selectedCharacter, int nmbrButton) {
+    // Move character selection to the right
+    if (IsKeyPressed(KEY_RIGHT)) {
+        selectedCharacter = (selectedCharacter + 1) % nmbrButton; // Wrap to the first character when exceeding available options
+    }
+    // Move character selection to the left
+    if (IsKeyPressed(KEY_LEFT)) {
+        selectedCharacter = (selectedCharacter - 1 + nmbrButton) % nmbrButton; // Wrap to the last character when going below the first
     }
+    return selectedCharacter; // Return the updated character selection index
+}
 
-    // Recursive function to generate the maze using depth-first search (DFS) with randomized directions
-    void generateMazeRecursive(int x, int y) {
-        // Mark the current cell as visited and remove its wall
-        grid[y][x].visited = true;
-        grid[y][x].isWall = false;
-
-        // Define possible directions to move in the maze
-        int directions[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
-
-        // Randomize the order of directions to ensure randomized path generation
-        for (int i = 0; i < 4; i++) {
-            int j = GetRandomValue(i, 3); // Random index to swap with the current index
-            int temp[2] = {directions[i][0], directions[i][1]};
-            directions[i][0] = directions[j][0];
-            directions[i][1] = directions[j][1];
-            directions[j][0] = temp[0];
-            directions[j][1] = temp[1];
-        }
+const int GIANT_MAZE_FACTOR = 6;        // A giant maze is this many screens wide and tall
+const int CAMPAIGN_DIFFICULTY = 6;      // Menu entry of the campaign mode
+const int LOADED_LEVEL_DIFFICULTY = 0;  // Level given with --level instead of picked in the menu
+const int RACE_DIFFICULTY = -1;         // Race joined with --host or --join, its maze comes from the server
+const int HINT_STEPS = 12;              // Cells of the way to the exit shown by the hint
+const int HINT_CHUNKS_PER_FRAME = 4;    // Chunks the endless hint generates per frame until it knows the way
+const int MENU_IDLE_FPS = 10;           // Frame rate of a menu nobody touches
+const double MENU_IDLE_SECONDS = 3.0;   // Time without input before the menu idles
+const int DEFAULT_AGENT_COUNT = 10000;  // Bots in the crowd toggled with B unless --agents says otherwise
+const float MIN_CAMERA_ZOOM = 1.0f / 64; // Furthest the mouse wheel zooms out of a fixed-size maze
+const float MINIMAP_SIZE = 320.0f;      // Longest side of the minimap (M key), in pixels
+const int WEB_SCREEN_WIDTH = 1280;      // Canvas size in the browser, which has no fullscreen before a click
+const int WEB_SCREEN_HEIGHT = 720;
+const char *const GAME_MUSIC_PATH = "Audio/rr.mp3";
+const int MAX_LEVEL_CANDIDATES = 64;    // Mazes generated at most for one level before keeping the hardest
+
+// Sprites of the atlas. Each character is followed by the others, then come their exits in the same order.
+enum GameSprite { SPRITE_MOUSE, SPRITE_MAN, SPRITE_CHILD, SPRITE_MOUSE_EXIT, SPRITE_MAN_EXIT, SPRITE_CHILD_EXIT,
+                  SPRITE_COUNT };
+
+// Image of each sprite. The exits are only ever drawn at the size of a cell, so they are packed small.
+// The menu background is not in the atlas: it is loaded on its own before the first frame.
+const SpriteSource spriteSources[SPRITE_COUNT] = {
+    {"img/ms.png", 0}, {"img/hm.png", 0}, {"img/c.png", 0},
+    {"img/jnn.png", 256}, {"img/fm.png", 256}, {"img/sc.png", 256}};
+const char *const MENU_BACKGROUND_PATH = "img/po.png";
+
+// Size of each maze cell for a difficulty level
+int difficultyCellSize(int difficulty) {
+    return (difficulty == 1) ? 50 : (difficulty == 2) ? 40 : 30;
+}
 
-        // Explore each direction
-        for (int i = 0; i < 4; i++) {
-            int nx = x + directions[i][0] * 2; // Next cell in the direction
-            int ny = y + directions[i][1] * 2;
-            if (isInsideGrid(nx, ny) && !grid[ny][nx].visited) { // Check if the cell is within bounds and unvisited
-                grid[y + directions[i][1]][x + directions[i][0]].isWall = false; // Remove wall between the two cells
-                generateMazeRecursive(nx, ny); // Recursively generate the maze from the new cell
-            }
-        }
-    }
+// Least tortuosity (solution length over the straight distance from the start to the exit) a
+// maze must reach to be played at a difficulty. Each rejects roughly the easiest fifth of the
+// mazes of its size, and giant mazes wind far more than one screen.
+float difficultyMinTortuosity(int difficulty) {
+    return (difficulty == 1) ? 2.2f : (difficulty == 2) ? 2.6f : (difficulty == 3) ? 3.2f : 12.0f;
+}
 
-public:
-    // Constructor for the Maze class, initializes the maze with specified dimensions and properties
-    Maze(int w, int h, int size, Color color, Texture2D exitTex) 
-        : width(w), height(h), cellSize(size), mazeColor(color), exitTexture(exitTex) {
-        // Allocate memory for the 2D maze grid
-        grid = new Cell*[height];
-        for (int i = 0; i < height; i++) {
-            grid[i] = new Cell[width];
-        }
-        generateMaze(); // Generate the initial maze
+// Color of the maze walls for a difficulty level
+Color difficultyColor(int difficulty) {
+    return (difficulty % 2 == 0) ? DARKGRAY : LIGHTGRAY;
+}
+
+// Difficulty of a campaign level: three levels of each fixed-size difficulty, then giant mazes
+int campaignDifficulty(int level) {
+    return std::min(1 + level / 3, 4);
+}
+
+// Builds the generation request of a fixed-size difficulty (giant mazes span several screens)
+LevelRequest makeLevelRequest(int difficulty, float screenWidth, float screenHeight) {
+    int cellSize = difficultyCellSize(difficulty);
+    int sizeFactor = (difficulty == 4) ? GIANT_MAZE_FACTOR : 1;
+
+    LevelRequest request;
+    request.difficulty = difficulty;
+    request.width = std::min((int)(screenWidth / cellSize) * sizeFactor, MAX_GENERATED_MAZE_SIDE);
+    request.height = std::min((int)(screenHeight / cellSize) * sizeFactor, MAX_GENERATED_MAZE_SIDE);
+    request.cellSize = cellSize;
+    request.color = difficultyColor(difficulty);
+    request.seed = makeRandomSeed();
+    request.minTortuosity = difficultyMinTortuosity(difficulty);
+    request.maxCandidates = MAX_LEVEL_CANDIDATES;
+    return request;
+}
 
-        // Set the exit position near the bottom-right corner
-        exitX = width - 2;
-        exitY = height - 2;
-        grid[exitY][exitX].isWall = false; // Ensure the exit is not a wall
+// Everything the menu screens show. The menu is only redrawn when this changes.
+struct MenuState {
+    bool characterSelection;            // Character selection instead of the difficulty menu
+    int button, character;              // Highlighted difficulty and character
+    bool waiting;                       // Waiting for the background maze
+    bool loading;                       // The character sprites are still being decoded
+    bool race;                          // The level is a race, waiting means waiting for its server
+
+    bool operator==(const MenuState &other) const {
+        return characterSelection == other.characterSelection && button == other.button &&
+               character == other.character && waiting == other.waiting && loading == other.loading &&
+               race == other.race;
     }
+};
 
-    // Destructor to clean up dynamically allocated memory
-    ~Maze() {
-        for (int i = 0; i < height; i++) {
-            delete[] grid[i];
-        }
+// Draws the difficulty menu or the character selection screen
+void drawMenuScreen(const MenuState &state, Texture2D background, const SpriteAtlas &atlas, const char *const *niveau,
+                    int nmbrNiveau, float menuSpacing, float screenWidth, float screenHeight) {
+    ClearBackground(RAYWHITE);
 
+    // Draw background
+    drawSprite(wholeTexture(background), {0, 0, screenWidth, screenHeight}, WHITE);
 
-        delete[] grid;
-    }
+    if (!state.characterSelection) {
+        // Draw menu screen with difficulty options
+        DrawText("Choisissez le niveau du jeu", screenWidth / 2 - 350, 100, 50, BLUE);
 
-    // Initiates the maze generation process
-    void generateMaze() {
-        generateMazeRecursive(1, 1);
+        for (int i = 0; i < nmbrNiveau; i++) {
+            float buttonY = 300 + i * menuSpacing;
+            if (i == state.button) {
+                DrawEllipse(screenWidth / 2, buttonY, 320, menuSpacing / 2, RED); // Highlight selected option
+            } else {
+                DrawEllipse(screenWidth / 2, buttonY, 300, menuSpacing * 0.4f, GOLD);
+            }
+            DrawText(niveau[i], screenWidth / 2 - 50, buttonY - 20, 40, BLACK);
+        }
+    } else {
+        // Draw character selection screen
+        DrawText("Choisissez votre personnage :", screenWidth / 2 - 400, 100, 50, BLUE);
+        if (state.loading) DrawText("Chargement des personnages...", screenWidth / 2 - 300, 500, 40, DARKGRAY);
+
+        drawSprite(atlas.frame(SPRITE_MOUSE, {0, 0, 700, 600}), {screenWidth / 4 - 150, 400, 300, 300}, WHITE);
+        drawSprite(atlas.frame(SPRITE_MAN, {0, 0, 700, 600}), {screenWidth / 2 - 150, 400, 300, 300}, WHITE);
+        drawSprite(atlas.frame(SPRITE_CHILD, {0, 0, 400, 400}), {3 * screenWidth / 4 - 150, 400, 300, 300}, WHITE);
+
+        if (state.character == 0)
+            DrawCircle(screenWidth / 4, 750, 50, RED);
+        else if (state.character == 1)
+            DrawCircle(screenWidth / 2, 750, 50, RED);
+        else
+            DrawCircle(3 * screenWidth / 4, 750, 50, RED);
+
+        if (state.waiting) {
+            DrawText(state.race ? "Connexion a la course..." : "Generation du labyrinthe...", screenWidth / 2 - 300, 850,
+                     40, BLUE);
+        }
     }
+}
 
-    // Checks if a given cell is a wall
-    bool isWall(int x, int y) const {
-        if (!isInsideGrid(x, y)) return true; // Treat out-of-bound coordinates as walls
-        return grid[y][x].isWall;
+// Centers the camera on the player (position in cells), clamped so it never shows outside the maze.
+// A maze smaller than the screen stays pinned to the top-left corner like before,
+// and an endless maze (INFINITY size) is only clamped at its top-left edges.
+Camera2D followCamera(Vector2 playerCell, int cellSize, float mazePixelWidth, float mazePixelHeight,
+                      float screenWidth, float screenHeight, float zoom) {
+    float halfWidth = screenWidth / 2 / zoom, halfHeight = screenHeight / 2 / zoom; // Half the view, in world pixels
+    float playerX = (playerCell.x + 0.5f) * cellSize;
+    float playerY = (playerCell.y + 0.5f) * cellSize;
+
+    Camera2D camera = {};
+    camera.offset = {screenWidth / 2, screenHeight / 2};
+    camera.zoom = zoom;
+    camera.target.x = (mazePixelWidth <= 2 * halfWidth) ? halfWidth :
+                      std::min(std::max(playerX, halfWidth), mazePixelWidth - halfWidth);
+    camera.target.y = (mazePixelHeight <= 2 * halfHeight) ? halfHeight :
+                      std::min(std::max(playerY, halfHeight), mazePixelHeight - halfHeight);
+    return camera;
+}
+
+// Marks one cell of the way to the exit, fading with its distance from the player
+void drawHintStep(int x, int y, int step, int cellSize) {
+    DrawCircle(x * cellSize + cellSize / 2, y * cellSize + cellSize / 2, cellSize / 6.0f, Fade(GOLD, 1.0f - (float)step / HINT_STEPS));
+}
+
+// Marks the next cells of the shortest path from the player to the exit
+void drawExitHint(const Maze &maze, const Player &player) {
+    int x = player.getX(), y = player.getY(), cellSize = maze.getCellSize();
+    int dx, dy;
+    for (int step = 0; step < HINT_STEPS && maze.nextStepToExit(x, y, dx, dy); step++) {
+        x += dx;
+        y += dy;
+        drawHintStep(x, y, step, cellSize);
     }
+}
 
-    // Draws the maze on the screen
-    void draw() const {
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                if (grid[y][x].isWall) {
-                    // Draw the walls of the maze
-                    DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, mazeColor);
+// Way to the exit of the endless maze, which has no distance field: a shortest path over
+// the chunks of the box around the player and the exit
+struct EndlessHint {
+    ChunkPathfinder paths;               // Chunks of the box walked so far
+    ChunkPathScratch scratch;
+    std::vector<PathCell> path;          // Cells from (fromX, fromY) to the exit, empty until known
+    int fromX = -1, fromY = -1;          // Player cell the path starts from
+
+    // Adds a few missing chunks of the box, so that no frame stalls on them, and finds the
+    // path again once the box is complete and the player has moved
+    void update(const ChunkedMaze &maze, const Player &player) {
+        int pcx = player.getX() / CHUNK_SIZE, pcy = player.getY() / CHUNK_SIZE;
+        int ecx = maze.getExitX() / CHUNK_SIZE, ecy = maze.getExitY() / CHUNK_SIZE;
+        int added = 0;
+        for (int cy = std::max(0, std::min(pcy, ecy) - 1); cy <= std::max(pcy, ecy) + 1; cy++) {
+            for (int cx = std::max(0, std::min(pcx, ecx) - 1); cx <= std::max(pcx, ecx) + 1; cx++) {
+                if (paths.hasChunk(cx, cy)) continue;
+                if (added == HINT_CHUNKS_PER_FRAME) {
+                    path.clear(); // The rest next frame
+                    return;
                 }
+                paths.addChunk(maze, cx, cy);
+                added++;
             }
         }
-
-        // Draw the exit texture at the exit position
-        Vector2 exitPosition = {(float)(exitX * cellSize), (float)(exitY * cellSize)};
-        DrawTextureEx(exitTexture, exitPosition, 0.0f, (float)cellSize / exitTexture.width, WHITE);
+        if (!path.empty() && fromX == player.getX() && fromY == player.getY()) return;
+        fromX = player.getX();
+        fromY = player.getY();
+        paths.findPath(fromX, fromY, maze.getExitX(), maze.getExitY(), path, scratch);
     }
 
-    // Checks if the given coordinates are at the exit position
-    bool isExit(int x, int y) const {
-        return x == exitX && y == exitY;
+    void draw(int cellSize) const {
+        for (int step = 0; step < HINT_STEPS && step < (int)path.size(); step++) {
+            drawHintStep(path[step].x, path[step].y, step, cellSize);
+        }
     }
 };
 
-/// Player class definition
-class Player {
-private:
-    int x, y;                    // Player's current position in the maze
-    int cellSize;               // Size of the player's representation (same as maze cell size)
-    float moveCooldown;         // Minimum time interval between two moves
-    float lastMoveTime;         // Timestamp of the last move to handle cooldown
-
-public:
-    // Constructor to initialize player's starting position, cell size, and movement properties
-    Player(int startX, int startY, int size) 
-        : x(startX), y(startY), cellSize(size), moveCooldown(0.2f), lastMoveTime(0.0f) {}
-
-    // Handles player movement while considering cooldowns and walls
-    void move(int dx, int dy, const Maze &maze) {
-        float currentTime = GetTime(); // Get the current system time
-        if (currentTime - lastMoveTime >= moveCooldown) { // Check if cooldown has passed
-            int newX = x + dx; // Proposed new X position
-            int newY = y + dy; // Proposed new Y position
-            if (!maze.isWall(newX, newY)) { // Check if the move leads to a non-wall cell
-                x = newX; // Move the player to the new position
-                y = newY;
-            }
-            lastMoveTime = currentTime; // Update the last move time
-        }
-    }
+// Returns the world-space rectangle seen through the camera
+Rectangle cameraView(const Camera2D &camera, float screenWidth, float screenHeight) {
+    return {camera.target.x - camera.offset.x / camera.zoom, camera.target.y - camera.offset.y / camera.zoom,
+            screenWidth / camera.zoom, screenHeight / camera.zoom};
+}
 
-    // Draws the player character at its current position
-    void draw(Texture2D character) const {
-        DrawTextureEx(character, {(float)(x * cellSize), (float)(y * cellSize)}, 0.0f, 
-                      (float)cellSize / character.width, WHITE);
-    }
+// Caps the frame rate. In the browser the page paces the frames, and waiting inside one
+// would block it, so the loop timing changes instead.
+void setFrameRate(int fps) {
+#if defined(PLATFORM_WEB)
+    if (fps > 0 && fps < 60) emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, 1000 / fps);
+    else emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+#else
+    SetTargetFPS(fps);
+#endif
+}
 
-    // Getter to access the player's current X coordinate
-    int getX() const { return x; }
+// Calls frame() once per frame until it returns false or the window is closed. In the
+// browser the page drives the frames, one emscripten_set_main_loop callback each, and the
+// call never returns: the stack of main() stays alive for the frames to use.
+template <typename Frame>
+void runMainLoop(Frame &frame) {
+#if defined(PLATFORM_WEB)
+    emscripten_set_main_loop_arg([](void *arg) {
+        if (!(*(Frame *)arg)()) emscripten_cancel_main_loop();
+    }, &frame, 0, 1);
+#else
+    while (!WindowShouldClose() && frame()) {}
+#endif
+}
 
-    // Getter to access the player's current Y coordinate
-    int getY() const { return y; }
-};
+#if defined(PLATFORM_WEB)
+// Set once the browser has downloaded the game music next to the preloaded files
+static bool gameMusicDownloaded = false;
+#endif
+
+// Checks recorded runs without opening a window and prints a line per run. Consecutive
+// replays of the same maze (a leaderboard sorted by level) share one generation.
+// Returns the process exit code: 0 when every run is valid.
+int validateReplays(const std::vector<const char *> &paths) {
+    std::unique_ptr<Maze> maze;
+    int failures = 0;
+    for (const char *path : paths) {
+        Replay replay;
+        if (!replay.load(path)) {
+            printf("%s: cannot read the replay\n", path);
+            failures++;
+            continue;
+        }
+        const ReplayFileHeader &header = replay.getHeader();
+        if (!maze || maze->getSeed() != header.seed || maze->getWidth() != header.width ||
+            maze->getHeight() != header.height || (uint32_t)maze->getAlgorithm() != header.algorithm) {
+            maze.reset(new Maze(header.width, header.height, header.cellSize, BLACK, Texture2D{}, header.seed,
+                                (MazeAlgorithm)header.algorithm));
+        }
 
-// Function to handle menu selection logic with keyboard input
-int choix(int selectedButton, int nmbrButton) {
-    // Move selection down
-    if (IsKeyPressed(KEY_DOWN)) {
-        selectedButton = (selectedButton + 1) % nmbrButton; // Wrap to the first button when exceeding the number of buttons
-    }
-    // Move selection up
-    if (IsKeyPressed(KEY_UP)) {
-        selectedButton = (selectedButton - 1 + nmbrButton) % nmbrButton; // Wrap to the last button when going below the first one
+        auto start = std::chrono::steady_clock::now();
+        ReplayCheck check = validateReplay(replay, *maze, 1, 1, MOVE_COOLDOWN_TICKS);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        printf("%s: %s, %u moves, %u ticks (%.2f s), checked in %.1f us\n", path, replayVerdictName(check.verdict),
+               check.moves, check.ticks, check.ticks / (double)SIMULATION_RATE, micros);
+        if (check.verdict != ReplayVerdict::Valid) failures++;
     }
-    return selectedButton; // Return the updated selection index
+    return failures == 0 ? 0 : 1;
 }
 
-// Function to handle character selection logic with keyboard input
-int choix2(int selectedCharacter, int nmbrButton) {
-    // Move character selection to the right
-    if (IsKeyPressed(KEY_RIGHT)) {
-        selectedCharacter = (selectedCharacter + 1) % nmbrButton; // Wrap to the first character when exceeding available options
-    }
-    // Move character selection to the left
-    if (IsKeyPressed(KEY_LEFT)) {
-        selectedCharacter = (selectedCharacter - 1 + nmbrButton) % nmbrButton; // Wrap to the last character when going below the first
+int main(int argc, char **argv) {
+    // --trace <file> writes the profiled frames as a Chrome trace when the game exits
+    // --level <file> plays a maze saved with F5 instead of picking a difficulty
+    // --fps <n> caps the frame rate (0 = uncapped), the default follows the monitor
+    // --agents <n> sets the size of the crowd toggled with B
+    // --record <dir> writes a replay of every finished level into dir
+    // --replay <file> plays a recorded run back, TAB fast-forwards
+    // --validate <file> checks a recorded run and exits without a window (repeat it for several runs)
+    // --host <port> hosts a race on a fresh maze and joins it, --join <host[:port]> joins one
+    const char *tracePath = nullptr;
+    const char *levelPath = nullptr;
+    const char *recordDir = nullptr;
+    const char *replayPath = nullptr;
+    std::vector<const char *> validatePaths;
+    const char *joinAddress = nullptr;
+    int hostPort = 0;
+    int gameFps = -1;
+    int agentCount = DEFAULT_AGENT_COUNT;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0) tracePath = argv[++i];
+        else if (strcmp(argv[i], "--level") == 0) levelPath = argv[++i];
+        else if (strcmp(argv[i], "--fps") == 0) gameFps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--agents") == 0) agentCount = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--record") == 0) recordDir = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0) replayPath = argv[++i];
+        else if (strcmp(argv[i], "--validate") == 0) validatePaths.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--host") == 0) hostPort = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--join") == 0) joinAddress = argv[++i];
     }
-    return selectedCharacter; // Return the updated character selection index
-}
+    if (!validatePaths.empty()) return validateReplays(validatePaths);
 
+    // Stage timings, shown with F3. Created first so the startup phases are timed from launch.
+    FrameProfiler profiler;
 
-int main() {
     // Initialize the game window
+    // Only what the first menu frame needs is loaded before it: the window and the menu
+    // background. The sprites stream in behind the menu, the audio waits for the second frame.
+    double phaseStart = profiler.timestamp();
+#if defined(PLATFORM_WEB)
+    InitWindow(WEB_SCREEN_WIDTH, WEB_SCREEN_HEIGHT, "Maze Game");
+    if (gameFps < 0) gameFps = 60; // The page renders at the display's rate whatever this says
+#else
     InitWindow(0, 0, "Maze Game");
-    InitAudioDevice();
-    SetTargetFPS(60);
 
     // Enable fullscreen mode
     ToggleFullscreen();
 
+    // Render at the display's refresh rate, the simulation keeps its own fixed rate
+    if (gameFps < 0) {
+        gameFps = GetMonitorRefreshRate(GetCurrentMonitor());
+        if (gameFps <= 0) gameFps = 60;
+    }
+    SetTargetFPS(gameFps);
+#endif
+    profiler.recordStartup("Window", phaseStart);
+
     // Get screen dimensions
     float screenWidth = GetScreenWidth();
     float screenHeight = GetScreenHeight();
 
     // Menu options for difficulty selection
-    const char *niveau[] = {"Facile", "Moyen", "Difficile", "Exit"};
+    const char *niveau[] = {"Facile", "Moyen", "Difficile", "Geant", "Infini", "Campagne", "Exit"};
+    const int nmbrNiveau = 7;
+    const int endlessExitChunks = 8;    // The endless maze exit is this many chunks right and down
+
+    // Spread the menu buttons over the screen height; with four buttons this is the original 200px spacing
+    float menuSpacing = std::min(200.0f, (screenHeight - 350) / (nmbrNiveau - 1));
 
     // Initial game state
     int selectedButton = 0;             // Currently selected menu button
     int selectedCharacter = 0;          // Currently selected character
     bool showCharacterSelection = false; // Whether to show character selection
+    bool showHint = false;              // Whether the way to the exit is shown (H key)
+    bool showMinimap = false;           // Whether the whole maze is shown in a corner (M key)
+    float cameraZoom = 1.0f;            // Zoom of the camera on fixed-size mazes (mouse wheel)
     int difficulty = 1;                 // Game difficulty level
 
     // Load textures for visuals
-    Texture2D background = LoadTexture("img/po.png");
-    Texture2D mouseTexture = LoadTexture("img/ms.png");
-    Texture2D manTexture = LoadTexture("img/hm.png");
-    Texture2D cTexture = LoadTexture("img/c.png");
-    Texture2D exitJnnTexture = LoadTexture("img/jnn.png");
-    Texture2D exitFmTexture = LoadTexture("img/fm.png");
-    Texture2D exitScTexture = LoadTexture("img/sc.png");
-
-    // Load menu and game music
-    Music menuMusic = LoadMusicStream("Audio/debut.mp3");
-    Music gameMusic = LoadMusicStream("Audio/rr.mp3");
-    SetMusicVolume(menuMusic, 0.5f);
-    SetMusicVolume(gameMusic, 0.5f);
+    // The menu background is needed by the first frame. The other sprites share one texture,
+    // decoded in parallel on a loader thread and uploaded by the frame that finds them ready.
+    phaseStart = profiler.timestamp();
+    Texture2D background = LoadTexture(MENU_BACKGROUND_PATH);
+    profiler.recordStartup("Menu background", phaseStart);
+    double spritesStart = profiler.timestamp();
+    SpriteAtlas atlas;
+    atlas.loadAsync(spriteSources, SPRITE_COUNT);
+    phaseStart = profiler.timestamp();
+    SpriteInstancer instancer;          // Draws the crowd in one call
+    instancer.load();
+    profiler.recordStartup("Instancer", phaseStart);
+
+    // Menu and game music, decoded by the music thread once opened. Both wait: the audio
+    // device for the first frame to be on screen, the game music for a level to be near.
+    MusicPlayer music;
+    Music menuMusic = {}, gameMusic = {};
+    int menuTrack = -1, gameTrack = -1; // Until the streams are opened
+    bool audioReady = false;            // Whether the audio device is open
+    bool firstFrameShown = false;       // Whether the first menu frame was presented
+#if defined(PLATFORM_WEB)
+    // Only the menu music comes with the page, the game music downloads behind the menu
+    emscripten_async_wget(GAME_MUSIC_PATH, GAME_MUSIC_PATH, [](const char *) { gameMusicDownloaded = true; },
+                          [](const char *path) { TraceLog(LOG_WARNING, "Cannot download %s", path); });
+    const bool &gameMusicAvailable = gameMusicDownloaded;
+#else
+    const bool gameMusicAvailable = true;
+#endif
 
     // Game state control variables
     bool gameStarted = false;
-    Maze* maze = nullptr;
-    Player* player = nullptr;
+    bool waitingForLevel = false;       // ENTER was pressed but the background maze is not ready yet
+    int requestedDifficulty = 0;        // Difficulty the background generator is working on (0 = none)
+    LevelPool levelPool;                // Finished levels, rewritten in place by the next ones
+    LevelGenerator levelGenerator(levelPool); // Builds mazes off the render thread
+    Campaign* campaign = nullptr;       // Pregenerates the campaign levels once the campaign is chosen
+    GeneratedLevel* currentLevel = nullptr; // Level being played, handed back to levelPool when it ends
+    Maze* maze = nullptr;               // Maze of currentLevel, or a maze loaded with --level
+    ChunkedMaze* endlessMaze = nullptr; // Used instead of maze in the endless mode
+    EndlessHint* endlessHint = nullptr; // Way to the endless exit, kept from the first H of the level
+    Player levelPlayer(1, 1, 1);        // Reset at the start of every level rather than reallocated
+    Player* player = nullptr;           // &levelPlayer while a level is played
+    AgentSwarm* swarm = nullptr;        // Crowd wandering the fixed-size maze, toggled with B
+    ThreadPool* swarmPool = nullptr;    // Steps the crowd, started with the first crowd
+
+    // Retained menu frame, recomposed only when the menu state changes
+    RenderTexture2D menuFrame = LoadRenderTexture((int)screenWidth, (int)screenHeight);
+    MenuState cachedMenuState = {};     // State menuFrame was composed from
+    bool menuFrameValid = false;        // Whether menuFrame holds a composed menu yet
+    double lastMenuInputTime = 0.0;     // Last time a key was pressed in the menu
+    bool menuIdle = false;              // Whether the menu runs at MENU_IDLE_FPS
+    double simulationTime = 0.0;        // Frame time not yet consumed by simulation ticks
+    uint32_t levelTick = 0;             // Simulation ticks since the level started
+    Replay recording;                   // Moves of the level being played
+    Replay playback;                    // Run given with --replay
+    ReplayCursor playbackCursor(playback); // Next move of the run being played back
+    ReplayMove nextMove = {};           // Move playbackCursor returned last
+    bool playingBack = false;           // Whether the player follows playback instead of the keyboard
+    bool hasNextMove = false;           // Whether nextMove is still to come
+    RaceServer* raceServer = nullptr;   // Race hosted with --host
+    RaceClient* raceClient = nullptr;   // Connection to the race joined, the hosted one included
+    double raceServerTime = 0.0;        // Frame time not yet consumed by server ticks
+
+    // Ends the maze being played: a generated one goes back to the pool, a loaded one is freed
+    auto releaseMaze = [&]() {
+        if (currentLevel) {
+            maze->releaseTextures();
+            levelPool.recycle(currentLevel);
+        } else {
+            delete maze;
+        }
+        currentLevel = nullptr;
+        maze = nullptr;
+    };
+
+    // A saved level skips the difficulty menu. Uncompressed files are mapped, not read.
+    // A replay regenerates its maze from the seed.
+    if (replayPath) {
+        if (playback.load(replayPath)) {
+            const ReplayFileHeader &header = playback.getHeader();
+            maze = new Maze(header.width, header.height, header.cellSize, difficultyColor(3), Texture2D{}, header.seed,
+                            (MazeAlgorithm)header.algorithm);
+            difficulty = LOADED_LEVEL_DIFFICULTY;
+            showCharacterSelection = true;
+            playingBack = true;
+        } else {
+            TraceLog(LOG_WARNING, "Cannot load the replay %s", replayPath);
+        }
+    } else if (levelPath) {
+        maze = Maze::load(levelPath, difficultyCellSize(3), difficultyColor(3), Texture2D{});
+        if (maze) {
+            difficulty = LOADED_LEVEL_DIFFICULTY;
+            showCharacterSelection = true;
+        } else {
+            TraceLog(LOG_WARNING, "Cannot load the maze file %s", levelPath);
+        }
+    } else if (hostPort > 0 || joinAddress) {
+        // A race skips it too. The host serves a maze of the hard difficulty's size, and
+        // every racer, the host included, generates it on its side once it has joined.
+        std::string address = joinAddress ? joinAddress : "";
+        if (hostPort > 0) {
+            LevelRequest request = makeLevelRequest(3, screenWidth, screenHeight);
+            raceServer = new RaceServer(request.width, request.height, request.seed);
+            if (raceServer->open((uint16_t)hostPort)) {
+                address = "127.0.0.1:" + std::to_string(hostPort);
+            } else {
+                TraceLog(LOG_WARNING, "Cannot host a race on port %d", hostPort);
+                delete raceServer;
+                raceServer = nullptr;
+            }
+        }
+        raceClient = new RaceClient();
+        if (!address.empty() && raceClient->connect(address.c_str())) {
+            difficulty = RACE_DIFFICULTY;
+            showCharacterSelection = true;
+        } else {
+            if (!address.empty()) TraceLog(LOG_WARNING, "Cannot join the race at %s", address.c_str());
+            delete raceClient;
+            raceClient = nullptr;
+        }
+    }
 
-    // Start playing menu music
-    PlayMusicStream(menuMusic);
+    // One frame of the game. Returns false once the player chooses to quit.
+    auto frame = [&]() -> bool {
+        profiler.beginFrame();
+        if (IsKeyPressed(KEY_F3)) profiler.toggleOverlay();
 
-    while (!WindowShouldClose()) { // Main game loop
-        if (!gameStarted) {
-            UpdateMusicStream(menuMusic);
+        // The rest of the startup, spread behind the first frames
+        if (atlas.poll()) {
+            profiler.recordStartup("Sprites", spritesStart);
+            menuFrameValid = false; // The character screen can show them now
+        }
+        if (firstFrameShown && !audioReady) {
+            // Open the audio device and start the menu music
+            phaseStart = profiler.timestamp();
+            InitAudioDevice();
+            menuMusic = loadBufferedMusic("Audio/debut.mp3");
+            SetMusicVolume(menuMusic, 0.5f);
+            menuTrack = music.add(menuMusic);
+            music.start();
+            if (!gameStarted) music.play(menuTrack);
+            audioReady = true;
+            profiler.recordStartup("Audio", phaseStart);
+        }
+        if (audioReady && gameTrack < 0 && gameMusicAvailable && (showCharacterSelection || gameStarted)) {
+            // A level is about to start (or started before the music came): open the game music
+            phaseStart = profiler.timestamp();
+            gameMusic = loadBufferedMusic(GAME_MUSIC_PATH);
+            SetMusicVolume(gameMusic, 0.5f);
+            gameTrack = music.add(gameMusic);
+            if (gameStarted) music.play(gameTrack);
+            profiler.recordStartup("Game music", phaseStart);
+        }
+        music.update(); // Feeds the audio where the music has no thread of its own
+
+        // A hosted race runs at the simulation rate whatever the host is doing
+        if (raceServer) {
+            int serverTicks = 0;
+            raceServerTime += GetFrameTime();
+            while (raceServerTime >= SIMULATION_TICK && serverTicks < MAX_TICKS_PER_FRAME) {
+                raceServer->update();
+                raceServerTime -= SIMULATION_TICK;
+                serverTicks++;
+            }
+            if (serverTicks == MAX_TICKS_PER_FRAME) raceServerTime = std::min(raceServerTime, SIMULATION_TICK);
+        }
+        if (raceClient) raceClient->update();
 
+        if (!gameStarted) {
+            simulationTime = 0.0; // A level starts with no backlog of ticks
             // Menu navigation and difficulty selection
+            profiler.begin(ProfileStage::Input);
             if (!showCharacterSelection) {
-                selectedButton = choix(selectedButton, 4); // Handle menu navigation
+                selectedButton = choix(selectedButton, nmbrNiveau); // Handle menu navigation
+
+                // Start generating the highlighted difficulty right away, so it is ready when chosen
+                int highlighted = selectedButton + 1;
+                if (highlighted <= 4 && highlighted != requestedDifficulty) {
+                    levelGenerator.request(makeLevelRequest(highlighted, screenWidth, screenHeight));
+                    requestedDifficulty = highlighted;
+                }
                 if (IsKeyPressed(KEY_ENTER)) {
-                    if (selectedButton == 3) { // Exit the game
-                        break;
+                    if (selectedButton == nmbrNiveau - 1) { // Exit the game
+                        return false;
                     } else {
                         difficulty = selectedButton + 1; // Set difficulty
+                        if (difficulty == CAMPAIGN_DIFFICULTY && !campaign) {
+                            // Generate the first levels on every core while the character is chosen
+                            campaign = new Campaign([=](int level) {
+                                return makeLevelRequest(campaignDifficulty(level), screenWidth, screenHeight);
+                            }, makeRandomSeed(), (int)std::max(2u, std::thread::hardware_concurrency()), levelPool);
+                        }
                         showCharacterSelection = true; // Show character selection screen
                     }
                 }
             } else {
                 // Handle character selection
-                selectedCharacter = choix2(selectedCharacter, 3);
-                if (IsKeyPressed(KEY_ENTER)) {
-                    // Start the game with chosen difficulty and character
-                    gameStarted = true;
-                    int cellSize = (difficulty == 1) ? 50 : (difficulty == 2) ? 40 : 30;
-                    int mazeWidth = screenWidth / cellSize;
-                    int mazeHeight = screenHeight / cellSize;
-                    Color mazeColor = (difficulty % 2 == 0) ? DARKGRAY : LIGHTGRAY;
-                    Texture2D exitTexture;
-                    
-                    // Set the exit texture based on selected character
-                    if (selectedCharacter == 0) {
-                        exitTexture = exitJnnTexture;
-                    } else if (selectedCharacter == 1) {
-                        exitTexture = exitFmTexture;
+                if (!waitingForLevel) selectedCharacter = choix2(selectedCharacter, 3);
+
+                bool levelReady = false;
+                if (IsKeyPressed(KEY_ENTER) && !waitingForLevel && atlas.isLoaded()) {
+                    if (difficulty == 5) {
+                        levelReady = true; // Endless chunks are generated as the player walks
+                    } else if (difficulty == LOADED_LEVEL_DIFFICULTY) {
+                        levelReady = true; // Loaded before the first frame
                     } else {
-                        exitTexture = exitScTexture;
+                        waitingForLevel = true; // Requested when the difficulty was highlighted
                     }
+                }
 
-                    // Create the maze and player
-                    maze = new Maze(mazeWidth, mazeHeight, cellSize, mazeColor, exitTexture);
-                    player = new Player(1, 1, cellSize);
-
-                    StopMusicStream(menuMusic);
-                    PlayMusicStream(gameMusic);
+                // Collect the background maze without ever blocking the frame
+                if (waitingForLevel && difficulty == RACE_DIFFICULTY) {
+                    // A race maze is generated here from the seed the server sent, it takes milliseconds
+                    if (raceClient->getState() == RaceClientState::Joined) {
+                        const RaceWelcome &welcome = raceClient->getWelcome();
+                        maze = new Maze(welcome.width, welcome.height, difficultyCellSize(3), difficultyColor(3),
+                                        Texture2D{}, welcome.seed, (MazeAlgorithm)welcome.algorithm);
+                        waitingForLevel = false;
+                        levelReady = true;
+                    } else if (raceClient->getState() == RaceClientState::Refused) {
+                        TraceLog(LOG_WARNING, "The race is full");
+                        waitingForLevel = false;
+                    }
+                } else if (waitingForLevel) {
+                    bool campaignLevel = (difficulty == CAMPAIGN_DIFFICULTY);
+                    GeneratedLevel *level = campaignLevel ? campaign->take() : levelGenerator.take();
+                    if (level && !campaignLevel && level->request.difficulty != difficulty) { // Left over from another highlight
+                        levelPool.recycle(level);
+                        level = nullptr;
+                    }
+                    if (level) {
+                        currentLevel = level;
+                        maze = level->maze;
+                        waitingForLevel = false;
+                        requestedDifficulty = 0; // Consumed: the next visit to the menu requests a fresh one
+                        levelReady = true;
+                    }
                 }
-            }
 
-            // Drawing menu screen
-            BeginDrawing();
-            ClearBackground(RAYWHITE);
+                if (levelReady) {
+                    ProfileScope scope(profiler, ProfileStage::Update);
 
-            // Draw background
-            DrawTexturePro(background, {0, 0, (float)background.width, (float)background.height}, 
-                           {0, 0, screenWidth, screenHeight}, {0, 0}, 0, WHITE);
+                    // Start the game with chosen difficulty and character
+                    gameStarted = true;
+                    int cellSize = maze ? maze->getCellSize() : difficultyCellSize(difficulty);
 
-            if (!showCharacterSelection) {
-                // Draw menu screen with difficulty options
-                DrawText("Choisissez le niveau du jeu", screenWidth / 2 - 350, 100, 50, BLUE);
+                    // Set the exit sprite based on selected character
+                    SpriteFrame exitSprite = atlas.frame(SPRITE_MOUSE_EXIT + selectedCharacter);
 
-                for (int i = 0; i < 4; i++) {
-                    if (i == selectedButton) {
-                        DrawEllipse(screenWidth / 2, 300 + i * 200, 320, 100, RED); // Highlight selected option
+                    // Finish the maze and create the player
+                    if (difficulty == 5) {
+                        endlessMaze = new ChunkedMaze(cellSize, difficultyColor(difficulty), exitSprite, makeRandomSeed(),
+                                                      endlessExitChunks);
                     } else {
-                        DrawEllipse(screenWidth / 2, 300 + i * 200, 300, 80, GOLD);
+                        maze->setExitSprite(exitSprite);
+                        maze->bakeWalls(); // Render the static walls once, before the first frame
                     }
-                    DrawText(niveau[i], screenWidth / 2 - 50, 280 + i * 200, 40, BLACK);
+                    levelPlayer = Player(1, 1, cellSize);
+                    player = &levelPlayer;
+                    levelTick = 0;
+                    if (maze) recording.begin(*maze);
+                    if (difficulty == RACE_DIFFICULTY) raceClient->start(*maze);
+                    if (playingBack) {
+                        playbackCursor = ReplayCursor(playback);
+                        hasNextMove = playbackCursor.next(nextMove);
+                    }
+
+                    music.stop(menuTrack);
+                    music.play(gameTrack);
                 }
-            } else {
-                // Draw character selection screen
-                DrawText("Choisissez votre personnage :", screenWidth / 2 - 400, 100, 50, BLUE);
-
-                DrawTexturePro(mouseTexture, {0, 0, 700, 600}, {screenWidth / 4 - 150, 400, 300, 300}, {0, 0}, 0, WHITE);
-                DrawTexturePro(manTexture, {0, 0, 700, 600}, {screenWidth / 2 - 150, 400, 300, 300}, {0, 0}, 0, WHITE);
-                DrawTexturePro(cTexture, {0, 0, 400, 400}, {3 * screenWidth / 4 - 150, 400, 300, 300}, {0, 0}, 0, WHITE);
-
-                if (selectedCharacter == 0)
-                    DrawCircle(screenWidth / 4, 750, 50, RED);
-                else if (selectedCharacter == 1)
-                    DrawCircle(screenWidth / 2, 750, 50, RED);
-                else
-                    DrawCircle(3 * screenWidth / 4, 750, 50, RED);
+            }
+            profiler.end(ProfileStage::Input);
+
+            // Drawing menu screen
+            // The menu only changes on input, so it is composed once into menuFrame and that
+            // texture is all a frame draws. Without input for a while the frame rate drops too.
+            profiler.begin(ProfileStage::Menu);
+            MenuState menuState = {showCharacterSelection, selectedButton, selectedCharacter, waitingForLevel,
+                                   !atlas.isLoaded(), difficulty == RACE_DIFFICULTY};
+            bool menuChanged = !menuFrameValid || !(menuState == cachedMenuState);
+            if (menuChanged || GetKeyPressed() != 0) lastMenuInputTime = GetTime();
+            if (menuChanged) {
+                BeginTextureMode(menuFrame);
+                drawMenuScreen(menuState, background, atlas, niveau, nmbrNiveau, menuSpacing, screenWidth, screenHeight);
+                EndTextureMode();
+                cachedMenuState = menuState;
+                menuFrameValid = true;
+            }
+
+            bool idle = GetTime() - lastMenuInputTime > MENU_IDLE_SECONDS;
+            if (idle != menuIdle) {
+                setFrameRate(idle ? MENU_IDLE_FPS : gameFps);
+                menuIdle = idle;
             }
 
-            EndDrawing();
+            BeginDrawing();
+            // Render textures are stored bottom-up, hence the negative source height
+            DrawTextureRec(menuFrame.texture, {0, 0, (float)menuFrame.texture.width, -(float)menuFrame.texture.height},
+                           {0, 0}, WHITE);
+            profiler.end(ProfileStage::Menu);
+
+            profiler.drawOverlay(10, 10);
+            {
+                ProfileScope scope(profiler, ProfileStage::Present); // Includes the wait for the frame rate cap
+                EndDrawing();
+            }
+            if (!firstFrameShown) {
+                profiler.recordStartup("First frame", 0.0);
+                firstFrameShown = true;
+            }
         } else {
-            UpdateMusicStream(gameMusic);
+            if (menuIdle) { // Back to full speed as soon as a level starts
+                setFrameRate(gameFps);
+                menuIdle = false;
+            }
 
             // Game logic: Handle player movement
-            if (IsKeyDown(KEY_UP)) player->move(0, -1, *maze);
-            if (IsKeyDown(KEY_DOWN)) player->move(0, 1, *maze);
-            if (IsKeyDown(KEY_LEFT)) player->move(-1, 0, *maze);
-            if (IsKeyDown(KEY_RIGHT)) player->move(1, 0, *maze);
+            profiler.begin(ProfileStage::Input);
+            // The first held key in the order up, down, left, right wins, like the original one move per call
+            int dx = 0, dy = 0;
+            if (IsKeyDown(KEY_UP)) dy = -1;
+            else if (IsKeyDown(KEY_DOWN)) dy = 1;
+            if (IsKeyDown(KEY_LEFT)) dx = -1;
+            else if (IsKeyDown(KEY_RIGHT)) dx = 1;
+            profiler.end(ProfileStage::Input);
+
+            profiler.begin(ProfileStage::Update);
+            // Run the simulation ticks this frame covers, stopping as soon as the exit is reached
+            bool atExit = false;
+            int ticks = 0;
+            simulationTime += GetFrameTime() * ((playingBack && IsKeyDown(KEY_TAB)) ? REPLAY_FAST_FORWARD : 1);
+            while (simulationTime >= SIMULATION_TICK && ticks < MAX_TICKS_PER_FRAME && !atExit) {
+                if (playingBack) { // The recorded move of this tick, if any, replaces the keyboard
+                    dx = dy = 0;
+                    if (hasNextMove && nextMove.tick == levelTick) {
+                        replayStep(nextMove.direction, dx, dy);
+                        hasNextMove = playbackCursor.next(nextMove);
+                    }
+                }
+                int fromX = player->getX(), fromY = player->getY();
+                if (raceClient) {
+                    // Predicted at once, the server only confirms it
+                    raceClient->tick(dx, dy);
+                    levelPlayer = raceClient->getPlayer();
+                    int movedX = player->getX() - fromX, movedY = player->getY() - fromY;
+                    if (std::abs(movedX) + std::abs(movedY) == 1) { // Not a correction from the server
+                        maze->revealFrom(player->getX(), player->getY());
+                        recording.record(levelTick, movedX, movedY);
+                    }
+                } else if (endlessMaze) {
+                    player->tick(dx, dy, *endlessMaze);
+                } else if (player->tick(dx, dy, *maze)) {
+                    maze->revealFrom(player->getX(), player->getY());
+                    recording.record(levelTick, player->getX() - fromX, player->getY() - fromY);
+                }
+                levelTick++;
+                if (swarm) swarm->tick(swarmPool);
+                atExit = endlessMaze ? endlessMaze->isExit(player->getX(), player->getY()) :
+                                       maze->isExit(player->getX(), player->getY());
+                if (raceClient) atExit = false; // The others are still racing, ENTER leaves (below)
+                simulationTime -= SIMULATION_TICK;
+                ticks++;
+            }
+            if (ticks == MAX_TICKS_PER_FRAME) simulationTime = std::min(simulationTime, SIMULATION_TICK);
+            if (raceClient && raceClient->getPlace(raceClient->getSlot()) > 0 && IsKeyPressed(KEY_ENTER)) atExit = true;
+            float tickAlpha = (float)(simulationTime / SIMULATION_TICK); // Progress toward the next tick
+
+            if (endlessMaze) {
+                endlessMaze->update(player->getX(), player->getY()); // Generate the chunks ahead of the player
+                if (IsKeyPressed(KEY_H)) showHint = !showHint;
+                if (showHint && !endlessHint) endlessHint = new EndlessHint();
+                if (showHint) endlessHint->update(*endlessMaze, *player);
+            } else {
+                if (IsKeyPressed(KEY_R)) {
+                    // Switch between the baked texture and the merged rectangle wall rendering
+                    maze->setRenderMode(maze->getRenderMode() == MazeRenderMode::Texture ?
+                                        MazeRenderMode::Rectangles : MazeRenderMode::Texture);
+                }
+                if (IsKeyPressed(KEY_H)) showHint = !showHint;
+                if (IsKeyPressed(KEY_M)) showMinimap = !showMinimap;
+                float wheel = GetMouseWheelMove();
+                if (wheel != 0) cameraZoom = std::min(1.0f, std::max(MIN_CAMERA_ZOOM, cameraZoom * powf(1.25f, wheel)));
+                if (IsKeyPressed(KEY_F)) {
+                    // Fog of war: only what the player has seen is shown
+                    maze->setFogEnabled(!maze->isFogEnabled());
+                    maze->revealFrom(player->getX(), player->getY());
+                }
+                if (IsKeyPressed(KEY_B)) {
+                    // Release or unleash a crowd of bots in the maze
+                    if (swarm) {
+                        delete swarm;
+                        swarm = nullptr;
+                    } else {
+                        if (!swarmPool) swarmPool = new ThreadPool();
+                        swarm = new AgentSwarm(maze->getGrid(), MOVE_COOLDOWN_TICKS);
+                        swarm->spawn(agentCount, mixSeed(maze->getSeed()));
+                    }
+                }
+                if (IsKeyPressed(KEY_F5)) {
+                    // Save the maze so it can be replayed with --level
+                    const char *path = TextFormat("maze_%016llx.maze", (unsigned long long)maze->getSeed());
+                    if (maze->save(path)) TraceLog(LOG_INFO, "Maze saved to %s", path);
+                    else TraceLog(LOG_WARNING, "Cannot save the maze to %s", path);
+                }
+            }
 
-            if (maze->isExit(player->getX(), player->getY())) {
+            profiler.end(ProfileStage::Update);
+            if (atExit) { // The crowd walks the maze that is about to go
+                delete swarm;
+                swarm = nullptr;
+            }
+            if (atExit && maze && recordDir && !playingBack) {
+                const char *path = TextFormat("%s/replay_%016llx_%u.mzr", recordDir, (unsigned long long)maze->getSeed(),
+                                              levelTick);
+                if (recording.save(path)) TraceLog(LOG_INFO, "Replay saved to %s", path);
+                else TraceLog(LOG_WARNING, "Cannot save the replay to %s", path);
+            }
+            if (atExit && campaign && difficulty == CAMPAIGN_DIFFICULTY) {
+                // Campaign: go straight to the next level when it is already generated
+                releaseMaze();
+                player = nullptr;
+                GeneratedLevel *level = campaign->take();
+                if (level) {
+                    currentLevel = level;
+                    maze = level->maze;
+                    maze->setExitSprite(atlas.frame(SPRITE_MOUSE_EXIT + selectedCharacter));
+                    maze->bakeWalls();
+                    levelPlayer = Player(1, 1, maze->getCellSize());
+                    player = &levelPlayer;
+                    levelTick = 0;
+                    recording.begin(*maze);
+                } else {
+                    // Still generating: wait on the character screen, which collects it
+                    gameStarted = false;
+                    waitingForLevel = true;
+                    music.stop(gameTrack);
+                    music.play(menuTrack);
+                }
+                return true;
+            }
+            if (atExit) {
                 // Handle level completion
-                delete maze;
-                delete player;
+                if (maze) releaseMaze();
+                delete raceClient; // A finished race is left, the hosted one goes on for the others
+                raceClient = nullptr;
+                delete endlessMaze;
+                endlessMaze = nullptr;
+                delete endlessHint;
+                endlessHint = nullptr;
+                player = nullptr;
+                playingBack = false; // A replay is played once, the keyboard is back for the next level
                 gameStarted = false;
                 showCharacterSelection = false;
-                StopMusicStream(gameMusic);
-                PlayMusicStream(menuMusic);
+                music.stop(gameTrack);
+                music.play(menuTrack);
+                return true; // The level is gone, the menu is drawn from the next frame on
             }
 
             // Drawing game screen
+            // The camera follows the player, only the cells it sees get drawn
+            int cellSize = endlessMaze ? endlessMaze->getCellSize() : maze->getCellSize();
+            float mazePixelWidth = endlessMaze ? INFINITY : (float)(maze->getWidth() * cellSize);
+            float mazePixelHeight = endlessMaze ? INFINITY : (float)(maze->getHeight() * cellSize);
+            float zoom = endlessMaze ? 1.0f : cameraZoom; // Zooming out of the endless maze would outrun its chunks
+            Camera2D camera = followCamera(player->getDrawPosition(tickAlpha), cellSize, mazePixelWidth, mazePixelHeight,
+                                           screenWidth, screenHeight, zoom);
+            Rectangle view = cameraView(camera, screenWidth, screenHeight);
+
             BeginDrawing();
             ClearBackground(RAYWHITE);
-            maze->draw(); // Draw the current state of the maze
-            Texture2D playerTexture = (selectedCharacter == 0) ? mouseTexture : 
-                                        (selectedCharacter == 1) ? manTexture : cTexture;
-            player->draw(playerTexture); // Draw the player
-            EndDrawing();
+            BeginMode2D(camera);
+            {
+                // Draw the visible part of the maze
+                ProfileScope scope(profiler, ProfileStage::Maze);
+                if (endlessMaze) endlessMaze->draw(view);
+                else maze->draw(view, zoom);
+                if (maze && showHint) drawExitHint(*maze, *player);
+                if (endlessMaze && showHint) endlessHint->draw(cellSize);
+            }
+            if (swarm) {
+                ProfileScope scope(profiler, ProfileStage::Player);
+                swarm->draw(view, cellSize, atlas.frame(SPRITE_MOUSE), Fade(DARKPURPLE, 0.8f), instancer);
+            }
+            if (raceClient) {
+                // The other racers, as the last snapshots put them
+                ProfileScope scope(profiler, ProfileStage::Player);
+                for (int slot = 0; slot < RACE_MAX_PLAYERS; slot++) {
+                    Vector2 position;
+                    if (!raceClient->getOpponent(slot, tickAlpha, position)) continue;
+                    drawSpriteScaled(atlas.frame(SPRITE_MOUSE + slot % 3), {position.x * cellSize, position.y * cellSize},
+                                     (float)cellSize, Fade(WHITE, 0.6f));
+                }
+            }
+            {
+                ProfileScope scope(profiler, ProfileStage::Player);
+                player->draw(atlas.frame(SPRITE_MOUSE + selectedCharacter), tickAlpha); // Draw the player
+            }
+            EndMode2D();
+            if (campaign && difficulty == CAMPAIGN_DIFFICULTY) {
+                DrawText(TextFormat("Niveau %d", campaign->getLevelsPlayed()), screenWidth - 220, 20, 40, BLUE);
+            }
+            if (raceClient) {
+                DrawText(TextFormat("Course : %d joueurs, %.1f o/joueur/tick", raceClient->getRacerCount(),
+                                    raceClient->getBytesPerRacer()), screenWidth - 640, 20, 30, BLUE);
+                int place = raceClient->getPlace(raceClient->getSlot());
+                if (place > 0) {
+                    DrawText(TextFormat("Arrive %d%s ! ENTREE pour quitter la course", place, place == 1 ? "er" : "e"),
+                             screenWidth / 2 - 400, screenHeight / 2 - 20, 40, RED);
+                }
+            }
+            if (maze && showMinimap && !maze->isFogEnabled()) { // The fog would be pointless with a map
+                ProfileScope scope(profiler, ProfileStage::Maze);
+                float scale = MINIMAP_SIZE / std::max(maze->getWidth(), maze->getHeight());
+                Rectangle area = {screenWidth - maze->getWidth() * scale - 20, 80, maze->getWidth() * scale,
+                                  maze->getHeight() * scale};
+                DrawRectangleRec(area, Fade(RAYWHITE, 0.85f));
+                maze->drawOverview(area, DARKGRAY);
+                Vector2 position = player->getDrawPosition(tickAlpha);
+                DrawCircleV({area.x + (position.x + 0.5f) * scale, area.y + (position.y + 0.5f) * scale},
+                            std::max(3.0f, scale), RED);
+            }
+            profiler.drawOverlay(10, 10);
+            {
+                ProfileScope scope(profiler, ProfileStage::Present); // Includes the wait for the frame rate cap
+                EndDrawing();
+            }
         }
-    }
+        return true;
+    };
+    runMainLoop(frame);
 
     // Cleanup textures, music, and game resources
+    atlas.unload();
     UnloadTexture(background);
-    UnloadTexture(mouseTexture);
-    UnloadTexture(manTexture);
-    UnloadTexture(cTexture);
-    UnloadTexture(exitJnnTexture);
-    UnloadTexture(exitFmTexture);
-    UnloadTexture(exitScTexture);
-    UnloadMusicStream(menuMusic);
-    UnloadMusicStream(gameMusic);
-
-    if (maze) delete maze;
-    if (player) delete player;
-
-    CloseAudioDevice();
+    instancer.unload();
+    UnloadRenderTexture(menuFrame);
+    music.shutdown(); // The music thread must be done with the streams before they go
+    if (menuTrack >= 0) UnloadMusicStream(menuMusic);
+    if (gameTrack >= 0) UnloadMusicStream(gameMusic);
+
+    if (maze) releaseMaze();
+    if (endlessMaze) delete endlessMaze;
+    if (endlessHint) delete endlessHint;
+    if (swarm) delete swarm;
+    if (swarmPool) delete swarmPool;
+    if (campaign) delete campaign;
+    if (raceClient) delete raceClient;
+    if (raceServer) delete raceServer;
+
+    if (tracePath && !profiler.writeChromeTrace(tracePath)) {
+        TraceLog(LOG_WARNING, "Cannot write the profiler trace to %s", tracePath);
+    }
+
+    if (audioReady) CloseAudioDevice();
     CloseWindow();
     return 0;
 }
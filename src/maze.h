@@ -0,0 +1,352 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include "raylib.h"
+#include "distance_field.h"
+#include "fog_of_war.h"
+#include "maze_file.h"
+#include "maze_generators.h"
+#include "maze_metrics.h"
+#include "sprite_atlas.h"
+#include "wall_grid.h"
+#include "wall_mip_chain.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+// How Maze::draw() renders the walls
+enum class MazeRenderMode {
+    Texture,     // Walls baked once into a render texture, drawn as one textured quad
+    Rectangles   // Walls merged into maximal rectangles, drawn as vector shapes (zoom friendly)
+};
+
+// Largest wall texture the maze bakes, in pixels. Bigger mazes always draw rectangles.
+const int MAX_BAKED_TEXTURE_SIZE = 8192;
+
+// Longest side of a maze the game generates. A giant maze of 30-pixel cells on an 8K
+// monitor is 1536 cells wide; a replay or race announcing more is damaged or hostile.
+const int MAX_GENERATED_MAZE_SIDE = 2048;
+
+// Below this many pixels per cell, the rectangle path draws a coarser level of the mip chain
+const float LOD_MIN_CELL_PIXELS = 3.0f;
+
+// Draws the merged wall rectangles that intersect the cell range [x0, x1) x [y0, y1).
+// Rectangles are in cells relative to (originX, originY) and sorted by top row, as
+// produced by mergeWallRects, so only a bounded slice of the list is visited.
+inline void drawWallRects(const std::vector<WallRect> &rects, int originX, int originY, int cellSize, Color color,
+                          int x0, int y0, int x1, int y1) {
+    auto first = std::lower_bound(rects.begin(), rects.end(), y0 - WALL_RECT_MAX_ROWS + 1,
+                                  [](const WallRect &rect, int row) { return rect.y < row; });
+    for (auto it = first; it != rects.end() && it->y < y1; ++it) {
+        const WallRect &rect = *it;
+        if (rect.y + rect.height <= y0 || rect.x >= x1 || rect.x + rect.width <= x0) continue;
+        // One DrawRectangle per merged block of walls
+        DrawRectangle((originX + rect.x) * cellSize, (originY + rect.y) * cellSize, rect.width * cellSize,
+                      rect.height * cellSize, color);
+    }
+}
+
+// Maze class definition
+// Class representing the maze grid, its exit and how it is drawn
+class Maze {
+private:
+    int width, height, cellSize;         // Dimensions of the maze and size of each cell
+    WallGrid grid;                       // Bit-packed wall plane of the maze
+    MazeAlgorithm algorithm;             // Algorithm used to carve the passages
+    uint64_t seed;                       // Seed of the generation, the same seed gives the same maze
+    int exitX, exitY;                    // Coordinates for the exit location
+    Color mazeColor;                     // Color of the maze walls
+    SpriteFrame exitSprite;              // Sprite to represent the exit point
+
+    // The walls never change after generation, so they are rendered once into a
+    // texture and each frame only draws that texture (one draw call instead of one per wall)
+    mutable RenderTexture2D wallTexture; // Baked wall layer, valid once wallsBaked is set
+    mutable bool wallsBaked;             // Whether wallTexture holds the current walls
+
+    MazeRenderMode renderMode;           // Current wall rendering path
+    std::vector<WallRect> wallRects;     // Greedy-merged walls used by the Rectangles path
+    DistanceField exitDistances;         // Walking distance of every cell to the exit
+    MazeMetrics metrics;                 // How hard the maze is, measured from the start cell (1, 1)
+    WallMipChain wallLods;               // Halved copies of the walls for zoomed-out views
+    std::unique_ptr<FogOfWar> fog;       // What the player has seen, created when the fog is first enabled
+    bool fogEnabled;                     // Whether draw() hides what the player has not seen
+
+    // Checks if the given coordinates are inside the maze boundaries
+    bool isInsideGrid(int x, int y) const {
+        return grid.isInside(x, y);
+    }
+
+    // Takes the settings of a new maze, clearing what the player did in the previous one
+    void resetState(int size, Color color, uint64_t mazeSeed, MazeAlgorithm algo) {
+        cellSize = size;
+        mazeColor = color;
+        seed = mazeSeed;
+        algorithm = algo;
+        renderMode = MazeRenderMode::Texture;
+        fogEnabled = false;
+        if (fog) fog->reset();
+    }
+
+    // Rebuilds what is derived from final walls and exit distances: metrics, mip chain, rectangles
+    void buildDerivedData() {
+        metrics = measureMaze(grid, exitDistances, 1, 1);
+        wallLods.build(grid);
+        wallRects.clear();
+        if (!canBakeWalls()) mergeWallRects(grid, wallRects);
+    }
+
+public:
+    // Constructor for the Maze class, initializes the maze with specified dimensions and properties
+    Maze(int w, int h, int size, Color color, Texture2D exitTex, uint64_t mazeSeed,
+         MazeAlgorithm algo = MazeAlgorithm::DFS)
+        : width(w), height(h), cellSize(size), grid(w, h), algorithm(algo), seed(mazeSeed),
+          mazeColor(color), exitSprite(wholeTexture(exitTex)),
+          wallTexture(), wallsBaked(false), renderMode(MazeRenderMode::Texture), fogEnabled(false) {
+        generateMaze(); // Generate the initial maze, its exit carved near the bottom-right corner
+        exitX = width - 2;
+        exitY = height - 2;
+
+        // The walls are final: map the way to the exit once, so hints cost nothing at runtime
+        exitDistances.build(grid, exitX, exitY);
+        buildDerivedData(); // Mazes too large for one texture get their walls merged into rectangles
+    }
+
+    // Constructor for a maze whose walls already exist, e.g. loaded from a file
+    Maze(WallGrid walls, int mazeExitX, int mazeExitY, int size, Color color, Texture2D exitTex, uint64_t mazeSeed,
+         MazeAlgorithm algo = MazeAlgorithm::DFS)
+        : width(walls.getWidth()), height(walls.getHeight()), cellSize(size), grid(std::move(walls)), algorithm(algo),
+          seed(mazeSeed), exitX(mazeExitX), exitY(mazeExitY), mazeColor(color), exitSprite(wholeTexture(exitTex)),
+          wallTexture(), wallsBaked(false), renderMode(MazeRenderMode::Texture), fogEnabled(false) {
+        exitDistances.build(grid, exitX, exitY);
+        buildDerivedData();
+    }
+
+    // Loads a maze saved with save(). Returns nullptr if the file cannot be read.
+    static Maze *load(const char *path, int size, Color color, Texture2D exitTex) {
+        WallGrid walls(0, 0);
+        MazeFileInfo info;
+        if (!loadMazeFile(path, walls, info) || info.algorithm >= (uint32_t)MAZE_ALGORITHM_COUNT) return nullptr;
+        return new Maze(std::move(walls), info.exitX, info.exitY, size, color, exitTex, info.seed,
+                        (MazeAlgorithm)info.algorithm);
+    }
+
+    // Saves the maze. Uncompressed files load by mapping them, compressed ones are smaller.
+    bool save(const char *path, bool compress = false) const {
+        MazeFileInfo info = {exitX, exitY, seed, (uint32_t)algorithm};
+        return saveMazeFile(path, grid, info, compress);
+    }
+
+    // Destructor to release the baked wall texture
+    ~Maze() {
+        releaseTextures();
+    }
+
+    // The baked texture is owned by a single maze
+    Maze(const Maze &) = delete;
+    Maze &operator=(const Maze &) = delete;
+
+    // Turns this maze into a new one, as if freshly constructed, reusing its buffers when the
+    // dimensions are the same. CPU only, so it can run on a worker once releaseTextures() was called.
+    void regenerate(int w, int h, int size, Color color, uint64_t mazeSeed, MazeAlgorithm algo = MazeAlgorithm::DFS) {
+        if (w == width && h == height && !grid.isExternal()) {
+            grid.fillWalls();
+        } else {
+            grid = WallGrid(w, h);
+            fog.reset(); // The fog is sized for the old grid
+        }
+        width = w;
+        height = h;
+        resetState(size, color, mazeSeed, algo);
+
+        generateMaze();
+        exitX = width - 2;
+        exitY = height - 2;
+        exitDistances.build(grid, exitX, exitY);
+        buildDerivedData();
+    }
+
+    // Turns this maze into the one carveWalls() made in walls, whose exit distances are given,
+    // as regenerate() would from its seed without carving or searching it again. The buffers
+    // are swapped rather than copied: the caller gets the previous ones back, e.g. to carve
+    // its next candidate. CPU only, like regenerate().
+    void adoptWalls(WallGrid &walls, DistanceField &distances, int size, Color color, uint64_t mazeSeed,
+                    MazeAlgorithm algo = MazeAlgorithm::DFS) {
+        if (walls.getWidth() != width || walls.getHeight() != height) fog.reset(); // The fog is sized for the old grid
+        std::swap(grid, walls);
+        std::swap(exitDistances, distances);
+        width = grid.getWidth();
+        height = grid.getHeight();
+        resetState(size, color, mazeSeed, algo);
+        exitX = width - 2;
+        exitY = height - 2;
+        buildDerivedData();
+    }
+
+    // Releases the baked wall and fog textures. Needs the window still open; a maze
+    // that was never drawn holds none, so this does nothing then.
+    void releaseTextures() {
+        if (wallsBaked) UnloadRenderTexture(wallTexture);
+        wallTexture = RenderTexture2D();
+        wallsBaked = false;
+        if (fog) fog->unloadTexture();
+    }
+
+    // Carves the maze of a seed, exit included, into walls of its dimensions that are all walls
+    static void carveWalls(WallGrid &walls, uint64_t mazeSeed, MazeAlgorithm algo) {
+        Rng rng(mazeSeed);
+        createMazeGenerator(algo)->generate(walls, rng);
+        walls.clearWall(walls.getWidth() - 2, walls.getHeight() - 2); // Ensure the exit is not a wall
+    }
+
+    // Initiates the maze generation process
+    void generateMaze() {
+        carveWalls(grid, seed, algorithm);
+    }
+
+    // Checks if a given cell is a wall
+    bool isWall(int x, int y) const {
+        if (!isInsideGrid(x, y)) return true; // Treat out-of-bound coordinates as walls
+        return grid.get(x, y);
+    }
+
+    // Checks if the whole maze fits in a single wall texture
+    bool canBakeWalls() const {
+        return width * cellSize <= MAX_BAKED_TEXTURE_SIZE && height * cellSize <= MAX_BAKED_TEXTURE_SIZE;
+    }
+
+    // Renders every wall once into the wall texture. Needs a window, and must be
+    // called outside of BeginMode2D since texture mode resets the transform.
+    void bakeWalls() const {
+        if (!canBakeWalls()) return;
+        if (wallsBaked) UnloadRenderTexture(wallTexture);
+        wallTexture = LoadRenderTexture(width * cellSize, height * cellSize);
+        wallsBaked = true;
+
+        BeginTextureMode(wallTexture);
+        ClearBackground(BLANK);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (grid.get(x, y)) {
+                    // Draw the walls of the maze
+                    DrawRectangle(x * cellSize, y * cellSize, cellSize, cellSize, mazeColor);
+                }
+            }
+        }
+        EndTextureMode();
+    }
+
+    // Selects how the walls are drawn, merging the wall rectangles on first use
+    void setRenderMode(MazeRenderMode mode) {
+        renderMode = mode;
+        if (mode == MazeRenderMode::Rectangles && wallRects.empty()) mergeWallRects(grid, wallRects);
+    }
+
+    MazeRenderMode getRenderMode() const { return renderMode; }
+
+    // Number of rectangles the Rectangles path draws per frame
+    size_t getWallRectCount() const { return wallRects.size(); }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getCellSize() const { return cellSize; }
+    uint64_t getSeed() const { return seed; }
+    MazeAlgorithm getAlgorithm() const { return algorithm; }
+
+    // Walls of the maze, 1 bit per cell
+    const WallGrid &getGrid() const { return grid; }
+
+    // Number of steps left from a cell to the exit, DistanceField::UNREACHABLE for walls
+    uint32_t distanceToExit(int x, int y) const { return exitDistances.distance(x, y); }
+
+    // Solution length, dead ends and the other difficulty metrics of the maze, from the start cell (1, 1)
+    const MazeMetrics &getMetrics() const { return metrics; }
+
+    // Direction of the step from a cell toward the exit along the shortest path.
+    // Returns false on the exit itself and on cells that cannot reach it.
+    bool nextStepToExit(int x, int y, int &dx, int &dy) const { return exitDistances.nextStep(x, y, dx, dy); }
+
+    // Sets the texture drawn at the exit (mazes generated in the background start without one)
+    void setExitTexture(Texture2D texture) { exitSprite = wholeTexture(texture); }
+
+    // Sets the exit to a sprite of an atlas
+    void setExitSprite(const SpriteFrame &sprite) { exitSprite = sprite; }
+
+    // Turns the fog of war on or off. What was seen is kept while it is off.
+    void setFogEnabled(bool enabled) {
+        fogEnabled = enabled;
+        if (enabled && !fog) fog.reset(new FogOfWar(grid));
+    }
+
+    bool isFogEnabled() const { return fogEnabled; }
+
+    // Updates what is in sight from the player's cell; call it when the player moves
+    void revealFrom(int x, int y) {
+        if (fog) fog->update(x, y);
+    }
+
+    // Draws the part of the maze inside the given world-space rectangle (e.g. the camera view)
+    // seen at the given camera zoom. Only the visible cells cost anything, whatever the size of
+    // the maze, and zoomed out far enough the walls come from a coarser level of the mip chain.
+    void draw(Rectangle view, float zoom = 1.0f) const {
+        // Visible range of cells, clamped to the maze
+        int x0 = std::max(0, (int)std::floor(view.x / cellSize));
+        int y0 = std::max(0, (int)std::floor(view.y / cellSize));
+        int x1 = std::min(width, (int)std::ceil((view.x + view.width) / cellSize));
+        int y1 = std::min(height, (int)std::ceil((view.y + view.height) / cellSize));
+
+        if (x0 < x1 && y0 < y1) {
+            int lod = (cellSize * zoom < LOD_MIN_CELL_PIXELS) ? wallLods.levelFor(LOD_MIN_CELL_PIXELS / (cellSize * zoom)) : 0;
+            if ((renderMode == MazeRenderMode::Rectangles || !canBakeWalls()) && lod > 0) {
+                // The visible range rounded out to whole cells of the level
+                int span = 1 << lod;
+                float lodCellSize = (float)(cellSize * span), origin = WallMipChain::levelOrigin(lod) * cellSize;
+                drawWallRuns(wallLods.level(lod), {origin, origin}, lodCellSize, lodCellSize, mazeColor, x0 / span,
+                             y0 / span, std::min(wallLods.level(lod).getWidth(), x1 / span + 1),
+                             std::min(wallLods.level(lod).getHeight(), y1 / span + 1));
+            } else if (renderMode == MazeRenderMode::Rectangles || !canBakeWalls()) {
+                drawWallRects(wallRects, 0, 0, cellSize, mazeColor, x0, y0, x1, y1);
+            } else {
+                if (!wallsBaked) bakeWalls();
+
+                // Render textures are stored bottom-up, so the source rectangle is taken
+                // from the bottom of the texture and flipped vertically
+                Rectangle dest = {(float)(x0 * cellSize), (float)(y0 * cellSize),
+                                  (float)((x1 - x0) * cellSize), (float)((y1 - y0) * cellSize)};
+                Rectangle source = {dest.x, wallTexture.texture.height - (dest.y + dest.height), dest.width, -dest.height};
+                DrawTexturePro(wallTexture.texture, source, dest, {0, 0}, 0.0f, WHITE);
+            }
+        }
+
+        // Draw the exit texture at the exit position
+        Vector2 exitPosition = {(float)(exitX * cellSize), (float)(exitY * cellSize)};
+        drawSpriteScaled(exitSprite, exitPosition, (float)cellSize, WHITE);
+
+        // The fog goes over the walls and the exit
+        if (fogEnabled && x0 < x1 && y0 < y1) fog->draw(x0, y0, x1, y1, cellSize);
+    }
+
+    // Draws the whole maze scaled to fit the given screen rectangle, e.g. as a minimap. Uses the
+    // mip level whose cells are about a pixel, so it costs the same whatever the maze size.
+    // Returns the pixels per maze cell it was drawn at.
+    float drawOverview(Rectangle area, Color color) const {
+        float scale = std::min(area.width / width, area.height / height);
+        int lod = wallLods.levelFor(1.0f / scale);
+        const WallGrid &walls = (lod == 0) ? grid : wallLods.level(lod);
+        float lodCellSize = scale * (1 << lod), origin = (lod == 0) ? 0.0f : WallMipChain::levelOrigin(lod) * scale;
+        drawWallRuns(walls, {area.x + origin, area.y + origin}, lodCellSize, lodCellSize, color, 0, 0, walls.getWidth(),
+                     walls.getHeight());
+        return scale;
+    }
+
+    // Draws the whole maze on the screen
+    void draw() const {
+        draw({0, 0, (float)(width * cellSize), (float)(height * cellSize)});
+    }
+
+    // Checks if the given coordinates are at the exit position
+    bool isExit(int x, int y) const {
+        return x == exitX && y == exitY;
+    }
+};
+
+#endif // MAZE_H
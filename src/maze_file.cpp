@@ -0,0 +1,203 @@
+// Maze file reading and writing.
+// Kept out of the headers because the memory mapping needs the platform headers,
+// and windows.h cannot be included next to raylib.h (both declare CloseWindow,
+// Rectangle, ...). This file therefore never includes raylib.h.
+
+#include "maze_file.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The format is little-endian and the wall plane is written as in memory, which
+// holds on every platform the game ships on (x86, ARM, WebAssembly).
+
+namespace {
+
+// Private (copy-on-write) mapping of a whole file, unmapped on destruction
+class FileMapping {
+private:
+    void *base;                          // Start of the mapped file, nullptr if not mapped
+    size_t length;                       // Size of the file in bytes
+#if defined(_WIN32)
+    HANDLE file, mapping;
+#endif
+
+public:
+    FileMapping() : base(nullptr), length(0) {
+#if defined(_WIN32)
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#endif
+    }
+
+    ~FileMapping() {
+#if defined(_WIN32)
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (base) munmap(base, length);
+#endif
+    }
+
+    FileMapping(const FileMapping &) = delete;
+    FileMapping &operator=(const FileMapping &) = delete;
+
+    // Maps the file. Writes through the mapping stay private to this process.
+    bool open(const char *path) {
+#if defined(_WIN32)
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return false;
+        length = (size_t)fileSize.QuadPart;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (!mapping) return false;
+        base = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        return base != nullptr;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        length = (size_t)status.st_size;
+        void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps its own reference to the file
+        if (mapped == MAP_FAILED) return false;
+        base = mapped;
+        return true;
+#endif
+    }
+
+    unsigned char *data() const { return (unsigned char *)base; }
+    size_t size() const { return length; }
+};
+
+// PackBits run-length encoding: a control byte n < 128 is followed by n + 1 literal
+// bytes, a control byte n >= 128 by one byte repeated n - 126 times (2 to 129).
+void encodeRuns(const unsigned char *input, size_t size, std::vector<unsigned char> &output) {
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < 129 && input[i + run] == input[i]) run++;
+        if (run >= 2) {
+            output.push_back((unsigned char)(run + 126));
+            output.push_back(input[i]);
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of at least two bytes
+        size_t start = i, count = 0;
+        while (i < size && count < 128 && !(i + 1 < size && input[i + 1] == input[i])) {
+            i++;
+            count++;
+        }
+        if (count == 0) continue; // A run starts right here
+        output.push_back((unsigned char)(count - 1));
+        output.insert(output.end(), input + start, input + start + count);
+    }
+}
+
+// Decodes exactly size bytes, returns false if the input is malformed or the wrong length
+bool decodeRuns(const unsigned char *input, size_t inputSize, unsigned char *output, size_t size) {
+    size_t in = 0, out = 0;
+    while (in < inputSize) {
+        unsigned char control = input[in++];
+        if (control < 128) {
+            size_t count = control + 1u;
+            if (in + count > inputSize || out + count > size) return false;
+            memcpy(output + out, input + in, count);
+            in += count;
+            out += count;
+        } else {
+            size_t count = control - 126u;
+            if (in >= inputSize || out + count > size) return false;
+            memset(output + out, input[in++], count);
+            out += count;
+        }
+    }
+    return out == size;
+}
+
+} // namespace
+
+bool saveMazeFile(const char *path, const WallGrid &grid, const MazeFileInfo &info, bool compress) {
+    const unsigned char *plane = (const unsigned char *)grid.data();
+    size_t planeSize = grid.byteSize();
+
+    std::vector<unsigned char> encoded;
+    if (compress) {
+        encoded.reserve(planeSize / 4);
+        encodeRuns(plane, planeSize, encoded);
+        compress = encoded.size() < planeSize; // Carved mazes are noisy: keep the mappable form when RLE does not pay
+    }
+
+    MazeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MAZE_FILE_MAGIC;
+    header.version = MAZE_FILE_VERSION;
+    header.flags = compress ? MAZE_FILE_RLE : 0;
+    header.width = grid.getWidth();
+    header.height = grid.getHeight();
+    header.exitX = info.exitX;
+    header.exitY = info.exitY;
+    header.seed = info.seed;
+    header.algorithm = info.algorithm;
+    header.stride = (uint32_t)grid.getStride();
+    header.payloadSize = compress ? encoded.size() : planeSize;
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (header.payloadSize > 0) {
+        written = written && fwrite(compress ? encoded.data() : plane, (size_t)header.payloadSize, 1, file) == 1;
+    }
+    return (fclose(file) == 0) && written;
+}
+
+bool loadMazeFile(const char *path, WallGrid &grid, MazeFileInfo &info) {
+    std::shared_ptr<FileMapping> mapping = std::make_shared<FileMapping>();
+    if (!mapping->open(path) || mapping->size() < sizeof(MazeFileHeader)) return false;
+
+    MazeFileHeader header;
+    memcpy(&header, mapping->data(), sizeof(header));
+    if (header.magic != MAZE_FILE_MAGIC || header.version != MAZE_FILE_VERSION) return false;
+    if (header.width <= 0 || header.height <= 0 || header.stride != (uint32_t)((header.width + 63) / 64)) return false;
+    if (header.exitX < 0 || header.exitX >= header.width || header.exitY < 0 || header.exitY >= header.height) return false;
+    if (header.payloadSize > mapping->size() - sizeof(MazeFileHeader)) return false;
+
+    size_t planeSize = (size_t)header.stride * header.height * sizeof(uint64_t);
+    const unsigned char *payload = mapping->data() + sizeof(MazeFileHeader);
+
+    if (header.flags & MAZE_FILE_RLE) {
+        WallGrid decoded(header.width, header.height);
+        if (!decodeRuns(payload, (size_t)header.payloadSize, (unsigned char *)decoded.data(), planeSize)) return false;
+        grid = std::move(decoded); // The mapping is released on return
+    } else {
+        if (header.payloadSize != planeSize) return false;
+        // Zero copy: the grid reads the mapped pages and keeps the mapping alive
+        uint64_t *plane = (uint64_t *)(mapping->data() + sizeof(MazeFileHeader));
+        grid = WallGrid(header.width, header.height, plane, mapping);
+    }
+
+    info.exitX = header.exitX;
+    info.exitY = header.exitY;
+    info.seed = header.seed;
+    info.algorithm = header.algorithm;
+    return true;
+}
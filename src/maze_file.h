@@ -0,0 +1,48 @@
+#ifndef MAZE_FILE_H
+#define MAZE_FILE_H
+
+#include "wall_grid.h"
+#include <cstdint>
+
+// On-disk maze format, all fields little-endian:
+//   MazeFileHeader    64 bytes
+//   wall plane        stride * height 64-bit words exactly as WallGrid stores them,
+//                     or their bytes run-length encoded when MAZE_FILE_RLE is set
+// The header is a multiple of 8 bytes, so in an uncompressed file mapped at a page
+// boundary the wall plane is word aligned and is used in place.
+const uint32_t MAZE_FILE_MAGIC = 0x455A414D; // "MAZE"
+const uint16_t MAZE_FILE_VERSION = 1;
+const uint16_t MAZE_FILE_RLE = 1;            // Header flag: the wall plane is compressed
+
+struct MazeFileHeader {
+    uint32_t magic;                      // MAZE_FILE_MAGIC
+    uint16_t version;                    // MAZE_FILE_VERSION
+    uint16_t flags;                      // MAZE_FILE_RLE or 0
+    int32_t width, height;               // Dimensions of the maze in cells
+    int32_t exitX, exitY;                // Coordinates of the exit
+    uint64_t seed;                       // Seed the maze was generated from
+    uint32_t algorithm;                  // MazeAlgorithm the maze was carved with
+    uint32_t stride;                     // 64-bit words per row of the wall plane
+    uint64_t payloadSize;                // Bytes of wall plane data after the header
+    uint8_t reserved[16];                // Zero, room for later versions
+};
+
+static_assert(sizeof(MazeFileHeader) == 64, "The maze file header must stay 64 bytes");
+
+// Everything about a saved maze besides its walls
+struct MazeFileInfo {
+    int exitX, exitY;                    // Coordinates of the exit
+    uint64_t seed;                       // Seed the maze was generated from
+    uint32_t algorithm;                  // MazeAlgorithm the maze was carved with
+};
+
+// Writes a maze file, run-length encoding the walls if compress is set. Returns false on I/O errors.
+bool saveMazeFile(const char *path, const WallGrid &grid, const MazeFileInfo &info, bool compress);
+
+// Reads a maze file. An uncompressed file is memory-mapped and the grid uses the
+// mapped wall plane directly (copy-on-write, the file itself is never modified);
+// a compressed one is decoded into a grid owning its walls. Returns false if the
+// file is missing, truncated or not a maze file, leaving grid and info untouched.
+bool loadMazeFile(const char *path, WallGrid &grid, MazeFileInfo &info);
+
+#endif // MAZE_FILE_H
@@ -0,0 +1,469 @@
+#ifndef MAZE_GENERATORS_H
+#define MAZE_GENERATORS_H
+
+#include "rng.h"
+#include "wall_grid.h"
+#include <memory>
+#include <utility>
+
+// Every generator works on the same lattice: passage cells sit at odd coordinates
+// (2i+1, 2j+1), and the even cells between two of them are the walls that get carved.
+// Generators receive a grid that is entirely walls and carve a perfect maze into it.
+
+// Number of passage cells per row of the lattice
+inline int latticeColumns(const WallGrid &grid) { return grid.getWidth() / 2; }
+
+// Number of passage cells per column of the lattice
+inline int latticeRows(const WallGrid &grid) { return grid.getHeight() / 2; }
+
+// Carves the lattice cell (i, j)
+inline void carveCell(WallGrid &grid, int i, int j) { grid.clearWall(2 * i + 1, 2 * j + 1); }
+
+// Checks if the lattice cell (i, j) has been carved yet
+inline bool isCellCarved(const WallGrid &grid, int i, int j) { return !grid.get(2 * i + 1, 2 * j + 1); }
+
+// Carves the wall between the lattice cell (i, j) and its neighbour (i + di, j + dj)
+inline void carvePassage(WallGrid &grid, int i, int j, int di, int dj) { grid.clearWall(2 * i + 1 + di, 2 * j + 1 + dj); }
+
+// Lattice directions shared by the generators: up, down, left, right
+static const int latticeDirections[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+// All 24 orders of the four directions, so a shuffled order costs a single draw
+static const uint8_t directionPermutations[24][4] = {
+    {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {0, 3, 2, 1},
+    {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0}, {1, 3, 0, 2}, {1, 3, 2, 0},
+    {2, 0, 1, 3}, {2, 0, 3, 1}, {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 3, 0, 1}, {2, 3, 1, 0},
+    {3, 0, 1, 2}, {3, 0, 2, 1}, {3, 1, 0, 2}, {3, 1, 2, 0}, {3, 2, 0, 1}, {3, 2, 1, 0},
+};
+
+// Interface implemented by every maze generation algorithm
+class MazeGenerator {
+public:
+    virtual ~MazeGenerator() {}
+
+    // Carves a perfect maze into a grid that starts out as all walls.
+    // The same grid size and rng state always produce the same maze.
+    virtual void generate(WallGrid &grid, Rng &rng) = 0;
+};
+
+// Randomized depth-first search, the original algorithm of the game.
+// Each cell draws an order of its four directions once on entry and then tries them
+// in that order; the state lives on an explicit stack so the call depth stays constant.
+class DfsGenerator : public MazeGenerator {
+private:
+    // One pending cell of the search, with its shuffled directions and the next one to try
+    struct Frame {
+        int x, y;                        // Cell being explored (grid coordinates)
+        uint8_t order;                   // Index in directionPermutations drawn for this cell
+        uint8_t next;                    // Index of the next direction to explore
+    };
+
+    std::vector<Frame> stack;            // Explicit DFS stack, preallocated to the maximum depth
+
+    // Marks a cell as carved and pushes it on the stack with a random direction order
+    void pushCell(WallGrid &grid, Rng &rng, int x, int y) {
+        // Remove the wall of the current cell, which also marks it as visited
+        grid.clearWall(x, y);
+        stack.push_back({x, y, (uint8_t)rng.below(24), 0});
+    }
+
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        if (latticeColumns(grid) == 0 || latticeRows(grid) == 0) return;
+
+        // A path can hold at most every lattice cell once, so reserve that up front
+        stack.clear();
+        stack.reserve((size_t)latticeColumns(grid) * latticeRows(grid));
+
+        // The search only ever lands on odd-coordinate cells, and those are carved
+        // exactly when they are visited, so the wall bit doubles as the visited flag
+        pushCell(grid, rng, 1, 1);
+        while (!stack.empty()) {
+            Frame &frame = stack.back();
+            if (frame.next == 4) { // Every direction explored: backtrack
+                stack.pop_back();
+                continue;
+            }
+
+            int direction = directionPermutations[frame.order][frame.next];
+            int dx = latticeDirections[direction][0];
+            int dy = latticeDirections[direction][1];
+            frame.next++;
+
+            int nx = frame.x + dx * 2; // Next cell in the direction
+            int ny = frame.y + dy * 2;
+            if (grid.isInside(nx, ny) && grid.get(nx, ny)) { // Check if the cell is within bounds and unvisited
+                grid.clearWall(frame.x + dx, frame.y + dy); // Remove wall between the two cells
+                pushCell(grid, rng, nx, ny); // Continue the search from the new cell (invalidates frame)
+            }
+        }
+
+        // Release the stack, it is only needed while generating
+        std::vector<Frame>().swap(stack);
+    }
+};
+
+// Iterative recursive-backtracker. Unlike DfsGenerator it re-draws among the
+// still-unvisited neighbours at every step, so the stack only holds cell indices.
+class BacktrackerGenerator : public MazeGenerator {
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        if (cols == 0 || rows == 0) return;
+
+        std::vector<uint32_t> stack;
+        stack.reserve((size_t)cols * rows);
+
+        carveCell(grid, 0, 0);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            int i = stack.back() % cols, j = stack.back() / cols;
+
+            // Collect the neighbours that have not been carved yet
+            int options[4], count = 0;
+            for (int d = 0; d < 4; d++) {
+                int ni = i + latticeDirections[d][0], nj = j + latticeDirections[d][1];
+                if (ni >= 0 && ni < cols && nj >= 0 && nj < rows && !isCellCarved(grid, ni, nj)) {
+                    options[count++] = d;
+                }
+            }
+            if (count == 0) { // Dead end: backtrack
+                stack.pop_back();
+                continue;
+            }
+
+            int d = options[rng.below(count)];
+            int ni = i + latticeDirections[d][0], nj = j + latticeDirections[d][1];
+            carvePassage(grid, i, j, latticeDirections[d][0], latticeDirections[d][1]);
+            carveCell(grid, ni, nj);
+            stack.push_back((uint32_t)(nj * cols + ni));
+        }
+    }
+};
+
+// Randomized Kruskal: shuffle every interior wall, then carve each one whose two
+// sides are not connected yet, tracked with a union-find over the lattice cells.
+class KruskalGenerator : public MazeGenerator {
+private:
+    std::vector<uint32_t> parent;        // Union-find forest over lattice cells
+    std::vector<uint8_t> rank;           // Upper bound of each tree height
+
+    // Finds the representative of a cell, halving the path along the way
+    uint32_t find(uint32_t c) {
+        while (parent[c] != c) {
+            parent[c] = parent[parent[c]];
+            c = parent[c];
+        }
+        return c;
+    }
+
+    // Merges the sets of two cells, returns false if they were already connected
+    bool unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (rank[a] < rank[b]) std::swap(a, b);
+        parent[b] = a;
+        if (rank[a] == rank[b]) rank[a]++;
+        return true;
+    }
+
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        size_t cells = (size_t)cols * rows;
+        if (cells == 0) return;
+
+        // Every wall is encoded as (cell << 1) | direction, 0 = right and 1 = down
+        std::vector<uint32_t> edges;
+        edges.reserve(cells * 2);
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < cols; i++) {
+                carveCell(grid, i, j);
+                uint32_t c = (uint32_t)(j * cols + i);
+                if (i + 1 < cols) edges.push_back(c << 1);
+                if (j + 1 < rows) edges.push_back((c << 1) | 1);
+            }
+        }
+
+        // Fisher-Yates shuffle of the walls
+        for (size_t k = edges.size(); k > 1; k--) {
+            std::swap(edges[k - 1], edges[rng.below((int)k)]);
+        }
+
+        parent.resize(cells);
+        rank.assign(cells, 0);
+        for (size_t c = 0; c < cells; c++) parent[c] = (uint32_t)c;
+
+        size_t remaining = cells - 1; // A spanning tree has exactly cells - 1 passages
+        for (size_t k = 0; k < edges.size() && remaining > 0; k++) {
+            uint32_t c = edges[k] >> 1;
+            bool down = edges[k] & 1;
+            if (unite(c, down ? c + cols : c + 1)) {
+                carvePassage(grid, c % cols, c / cols, down ? 0 : 1, down ? 1 : 0);
+                remaining--;
+            }
+        }
+
+        std::vector<uint32_t>().swap(parent);
+        std::vector<uint8_t>().swap(rank);
+    }
+};
+
+// Randomized Prim: grow the maze from one cell, each step connecting a random
+// frontier cell to a random neighbour that is already part of the maze.
+class PrimGenerator : public MazeGenerator {
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        size_t cells = (size_t)cols * rows;
+        if (cells == 0) return;
+
+        std::vector<uint32_t> frontier;
+        std::vector<bool> inFrontier(cells, false);
+
+        // Carves a cell and adds its uncarved neighbours to the frontier
+        auto addCell = [&](int i, int j) {
+            carveCell(grid, i, j);
+            for (int d = 0; d < 4; d++) {
+                int ni = i + latticeDirections[d][0], nj = j + latticeDirections[d][1];
+                if (ni < 0 || ni >= cols || nj < 0 || nj >= rows) continue;
+                size_t n = (size_t)nj * cols + ni;
+                if (!inFrontier[n] && !isCellCarved(grid, ni, nj)) {
+                    inFrontier[n] = true;
+                    frontier.push_back((uint32_t)n);
+                }
+            }
+        };
+
+        addCell(rng.below(cols), rng.below(rows));
+        while (!frontier.empty()) {
+            // Take a random frontier cell out with a swap-and-pop
+            int k = rng.below((int)frontier.size());
+            uint32_t c = frontier[k];
+            frontier[k] = frontier.back();
+            frontier.pop_back();
+            int i = c % cols, j = c / cols;
+
+            // Connect it to one of its neighbours already in the maze
+            int options[4], count = 0;
+            for (int d = 0; d < 4; d++) {
+                int ni = i + latticeDirections[d][0], nj = j + latticeDirections[d][1];
+                if (ni >= 0 && ni < cols && nj >= 0 && nj < rows && isCellCarved(grid, ni, nj)) {
+                    options[count++] = d;
+                }
+            }
+            int d = options[rng.below(count)];
+            carvePassage(grid, i, j, latticeDirections[d][0], latticeDirections[d][1]);
+            addCell(i, j);
+        }
+    }
+};
+
+// Eller's algorithm, one row at a time. Only the current row's sets are kept, so a
+// maze of any height can be produced in O(columns) memory by calling nextRow repeatedly.
+class EllerRowGenerator {
+private:
+    int columns;                         // Number of lattice cells per row
+    std::vector<int> sets;               // Set label of each column in the current row (-1 = none yet)
+    std::vector<int> parent;             // Union-find over the labels of the current row
+    std::vector<int> members;            // Members of each set not yet given a vertical decision
+    std::vector<int> remap;              // Label compaction table used when carrying sets down
+    std::vector<char> hasDown;           // Whether each set already has a passage to the next row
+    std::vector<char> right, down;       // Openings produced for the current row
+
+    int find(int label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+public:
+    explicit EllerRowGenerator(int cols)
+        : columns(cols), sets(cols, -1), parent(2 * cols), members(2 * cols), remap(2 * cols, -1),
+          hasDown(2 * cols, 0), right(cols, 0), down(cols, 0) {}
+
+    // Decides the openings of the next row. The last row joins every remaining set.
+    void nextRow(bool lastRow, Rng &rng) {
+        // Carried labels are compacted into [0, columns), fresh ones use [columns, 2 * columns)
+        for (int c = 0; c < columns; c++) {
+            if (sets[c] < 0) sets[c] = columns + c;
+            parent[sets[c]] = sets[c];
+        }
+
+        // Join adjacent cells from different sets at random (always on the last row)
+        for (int c = 0; c < columns; c++) {
+            right[c] = 0;
+            if (c + 1 == columns) break;
+            int a = find(sets[c]), b = find(sets[c + 1]);
+            if (a != b && (lastRow || rng.below(2))) {
+                parent[b] = a;
+                right[c] = 1;
+            }
+        }
+
+        if (lastRow) {
+            for (int c = 0; c < columns; c++) down[c] = 0;
+            return;
+        }
+
+        // Open passages down at random, forcing one on the last member of a set that has none
+        for (int c = 0; c < columns; c++) members[find(sets[c])] = 0;
+        for (int c = 0; c < columns; c++) members[find(sets[c])]++;
+        for (int c = 0; c < columns; c++) {
+            int r = find(sets[c]);
+            members[r]--;
+            down[c] = (char)rng.below(2);
+            if (!hasDown[r] && members[r] == 0) down[c] = 1;
+            if (down[c]) hasDown[r] = 1;
+        }
+
+        // Carry the sets down to the next row, relabelled compactly
+        int next = 0;
+        for (int c = 0; c < columns; c++) {
+            int r = find(sets[c]);
+            if (down[c] && remap[r] < 0) remap[r] = next++;
+            sets[c] = down[c] ? remap[r] : -1;
+        }
+        for (int l = 0; l < 2 * columns; l++) {
+            remap[l] = -1;
+            hasDown[l] = 0;
+        }
+    }
+
+    // Whether the cell in column c opens to its right neighbour in the current row
+    bool opensRight(int c) const { return right[c] != 0; }
+
+    // Whether the cell in column c opens to the cell below it
+    bool opensDown(int c) const { return down[c] != 0; }
+};
+
+// Eller's algorithm over the whole grid, built on EllerRowGenerator
+class EllerGenerator : public MazeGenerator {
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        if (cols == 0 || rows == 0) return;
+
+        EllerRowGenerator eller(cols);
+        for (int j = 0; j < rows; j++) {
+            eller.nextRow(j == rows - 1, rng);
+            for (int i = 0; i < cols; i++) {
+                carveCell(grid, i, j);
+                if (eller.opensRight(i)) carvePassage(grid, i, j, 1, 0);
+                if (eller.opensDown(i)) carvePassage(grid, i, j, 0, 1);
+            }
+        }
+    }
+};
+
+// Wilson's algorithm: loop-erased random walks from every cell not yet in the maze.
+// Produces a uniformly random spanning tree, at the cost of long first walks.
+class WilsonGenerator : public MazeGenerator {
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        size_t cells = (size_t)cols * rows;
+        if (cells == 0) return;
+
+        // Direction last taken out of each cell; overwriting it on revisits erases the loops
+        std::vector<uint8_t> walk(cells);
+
+        carveCell(grid, rng.below(cols), rng.below(rows));
+        for (int sj = 0; sj < rows; sj++) {
+            for (int si = 0; si < cols; si++) {
+                if (isCellCarved(grid, si, sj)) continue;
+
+                // Walk at random until the maze is reached
+                int i = si, j = sj;
+                while (!isCellCarved(grid, i, j)) {
+                    int d, ni, nj;
+                    do {
+                        d = rng.below(4);
+                        ni = i + latticeDirections[d][0];
+                        nj = j + latticeDirections[d][1];
+                    } while (ni < 0 || ni >= cols || nj < 0 || nj >= rows);
+                    walk[(size_t)j * cols + i] = (uint8_t)d;
+                    i = ni;
+                    j = nj;
+                }
+
+                // Carve the loop-erased path by following the last direction out of each cell
+                i = si;
+                j = sj;
+                while (!isCellCarved(grid, i, j)) {
+                    int d = walk[(size_t)j * cols + i];
+                    carveCell(grid, i, j);
+                    carvePassage(grid, i, j, latticeDirections[d][0], latticeDirections[d][1]);
+                    i += latticeDirections[d][0];
+                    j += latticeDirections[d][1];
+                }
+            }
+        }
+    }
+};
+
+// Binary tree: every cell opens either up or left. No extra memory at all,
+// but the mazes have a strong diagonal bias and open top row and left column.
+class BinaryTreeGenerator : public MazeGenerator {
+public:
+    void generate(WallGrid &grid, Rng &rng) override {
+        int cols = latticeColumns(grid), rows = latticeRows(grid);
+        for (int j = 0; j < rows; j++) {
+            for (int i = 0; i < cols; i++) {
+                carveCell(grid, i, j);
+                bool up = j > 0 && (i == 0 || rng.below(2));
+                if (up) carvePassage(grid, i, j, 0, -1);
+                else if (i > 0) carvePassage(grid, i, j, -1, 0);
+            }
+        }
+    }
+};
+
+// Available maze generation algorithms, in registry order
+enum class MazeAlgorithm {
+    DFS,
+    Backtracker,
+    Kruskal,
+    Prim,
+    Eller,
+    Wilson,
+    BinaryTree
+};
+
+const int MAZE_ALGORITHM_COUNT = 7;
+
+// Registry entry: display name and factory of one algorithm
+struct MazeGeneratorEntry {
+    MazeAlgorithm algorithm;
+    const char *name;
+    std::unique_ptr<MazeGenerator> (*create)();
+};
+
+template <typename T>
+std::unique_ptr<MazeGenerator> makeMazeGenerator() {
+    return std::unique_ptr<MazeGenerator>(new T());
+}
+
+// Returns the registry of every algorithm, indexed by MazeAlgorithm
+inline const MazeGeneratorEntry *getMazeGenerators() {
+    static const MazeGeneratorEntry entries[MAZE_ALGORITHM_COUNT] = {
+        {MazeAlgorithm::DFS, "dfs", makeMazeGenerator<DfsGenerator>},
+        {MazeAlgorithm::Backtracker, "backtracker", makeMazeGenerator<BacktrackerGenerator>},
+        {MazeAlgorithm::Kruskal, "kruskal", makeMazeGenerator<KruskalGenerator>},
+        {MazeAlgorithm::Prim, "prim", makeMazeGenerator<PrimGenerator>},
+        {MazeAlgorithm::Eller, "eller", makeMazeGenerator<EllerGenerator>},
+        {MazeAlgorithm::Wilson, "wilson", makeMazeGenerator<WilsonGenerator>},
+        {MazeAlgorithm::BinaryTree, "binary-tree", makeMazeGenerator<BinaryTreeGenerator>},
+    };
+    return entries;
+}
+
+// Creates a generator for the given algorithm
+inline std::unique_ptr<MazeGenerator> createMazeGenerator(MazeAlgorithm algorithm) {
+    return getMazeGenerators()[(int)algorithm].create();
+}
+
+#endif // MAZE_GENERATORS_H
@@ -0,0 +1,70 @@
+#ifndef MAZE_METRICS_H
+#define MAZE_METRICS_H
+
+#include "distance_field.h"
+#include "wall_grid.h"
+#include "wall_kernels.h"
+#include <cstdint>
+#include <cstdlib>
+
+// What makes a maze hard to solve, measured once its walls and exit distances are final
+struct MazeMetrics {
+    uint32_t solutionLength;             // Steps from the start to the exit, DistanceField::UNREACHABLE if cut off
+    uint32_t solutionDecisions;          // Junctions walked through on the way, each a chance to go wrong
+    size_t openCells;                    // Cells that are not walls
+    size_t deadEnds;                     // Open cells with a single open neighbor
+    size_t junctions;                    // Open cells with three or four open neighbors
+    float branchingFactor;               // Ways on out of a junction, on average (0 without junctions)
+    float averageCorridorLength;         // Steps between two dead ends or junctions, on average
+
+    // Solution length over the straight-line (Manhattan) distance it covers: 1 is a straight
+    // corridor, and the more the path winds the harder the maze, whatever its dimensions
+    float tortuosity(int startX, int startY, int exitX, int exitY) const {
+        int direct = std::abs(exitX - startX) + std::abs(exitY - startY);
+        if (solutionLength == DistanceField::UNREACHABLE || direct == 0) return 0.0f;
+        return (float)solutionLength / direct;
+    }
+};
+
+// Measures a maze in one streaming pass over the wall rows plus a walk of the solution. Each
+// row is classified from a single neighbor count per word while it and its neighbors are
+// still in cache, so a maze of millions of cells is measured in a few milliseconds; the
+// solution comes from the exit distance field, built from the same walls, without another search.
+inline MazeMetrics measureMaze(const WallGrid &grid, const DistanceField &exitDistances, int startX, int startY) {
+    MazeMetrics metrics = {};
+    int height = grid.getHeight();
+
+    // Open cells by their number of open neighbors, a row at a time
+    size_t byNeighbors[5] = {};
+    for (int y = 0; y < height; y++) {
+        const uint64_t *above = y > 0 ? grid.row(y - 1) : nullptr, *below = y + 1 < height ? grid.row(y + 1) : nullptr;
+        countRowByOpenNeighbors(above, grid.row(y), below, grid.getStride(), grid.getWidth(), byNeighbors);
+    }
+    metrics.openCells = byNeighbors[0] + byNeighbors[1] + byNeighbors[2] + byNeighbors[3] + byNeighbors[4];
+    metrics.deadEnds = byNeighbors[1];
+    metrics.junctions = byNeighbors[3] + byNeighbors[4];
+    if (metrics.junctions > 0) {
+        metrics.branchingFactor = (float)(3 * byNeighbors[3] + 4 * byNeighbors[4]) / metrics.junctions - 1.0f;
+    }
+
+    // Every corridor runs between two cells that are not corridor cells, and every step is
+    // counted once by each of its two ends
+    size_t corridorEnds = byNeighbors[1] + 3 * byNeighbors[3] + 4 * byNeighbors[4];
+    size_t steps = byNeighbors[1] + 2 * byNeighbors[2] + 3 * byNeighbors[3] + 4 * byNeighbors[4];
+    if (corridorEnds > 0) metrics.averageCorridorLength = (float)steps / corridorEnds;
+
+    // Follow the distance field from the start, counting the junctions on the way
+    metrics.solutionLength = exitDistances.distance(startX, startY);
+    if (metrics.solutionLength == DistanceField::UNREACHABLE) return metrics;
+    int x = startX, y = startY, dx, dy;
+    while (exitDistances.nextStep(x, y, dx, dy)) {
+        x += dx;
+        y += dy;
+        int open = (grid.isInside(x - 1, y) && !grid.get(x - 1, y)) + (grid.isInside(x + 1, y) && !grid.get(x + 1, y)) +
+                   (grid.isInside(x, y - 1) && !grid.get(x, y - 1)) + (grid.isInside(x, y + 1) && !grid.get(x, y + 1));
+        metrics.solutionDecisions += open >= 3;
+    }
+    return metrics;
+}
+
+#endif // MAZE_METRICS_H
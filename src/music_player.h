@@ -0,0 +1,119 @@
+#ifndef MUSIC_PLAYER_H
+#define MUSIC_PLAYER_H
+
+#include "raylib.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Frames per half of a music stream buffer. raylib's default is one device period
+// (about 10 ms), which runs dry as soon as a frame is late; this holds about 0.75 s
+// at 44.1 kHz, so every stream keeps about 1.5 s of decoded audio queued.
+const unsigned int MUSIC_BUFFER_FRAMES = 32768;
+
+// Loads a music stream with the deep buffers MusicPlayer relies on
+inline Music loadBufferedMusic(const char *path) {
+    SetAudioStreamBufferSizeDefault(MUSIC_BUFFER_FRAMES);
+    Music music = LoadMusicStream(path);
+    SetAudioStreamBufferSizeDefault(0);
+    return music;
+}
+
+// MusicPlayer class definition
+// Decodes the music on its own thread, so a long frame (a big maze being built,
+// a slow present) never starves the audio device. Once started, the thread owns
+// the tracks: the game thread only posts play/stop commands through a lock-free
+// single-producer single-consumer ring and never calls raylib's music functions.
+//
+// The thread also keeps every stopped track's buffers filled with its opening
+// seconds (stopping rewinds a track, and refilling a stopped stream does not
+// start it), so switching tracks starts on already decoded audio with no gap.
+//
+// In the browser the audio device belongs to the page's thread, so there is no
+// music thread: update(), called every frame, does its work instead. The deep
+// buffers cover the slow frames there too.
+class MusicPlayer {
+private:
+    enum class CommandType { Add, Play, Stop };
+
+    struct Command {
+        CommandType type;
+        int track;
+        Music music;                     // Stream of an Add
+    };
+
+    std::vector<Music> tracks;           // Streams owned by the caller, only touched by the audio thread once started
+    int trackCount;                      // Tracks added so far, including those still in the ring
+    SpscRing<Command, 64> commands;      // Game thread to audio thread
+    std::thread worker;                  // Audio thread, running once started
+    std::atomic<bool> running;           // Cleared to stop the audio thread
+
+    // Applies the commands, then tops up every stream
+    void service() {
+        Command command;
+        while (commands.pop(command)) {
+            if (command.type == CommandType::Add) tracks.push_back(command.music);
+            else if (command.type == CommandType::Play) PlayMusicStream(tracks[command.track]);
+            else StopMusicStream(tracks[command.track]);
+        }
+        // Refills the buffers the device has consumed; for a stopped track this preloads its start
+        for (Music &track : tracks) UpdateMusicStream(track);
+    }
+
+    // Audio thread loop
+    void run() {
+        while (running.load(std::memory_order_acquire)) {
+            service();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+public:
+    MusicPlayer() : trackCount(0), running(false) {}
+
+    ~MusicPlayer() { shutdown(); }
+
+    MusicPlayer(const MusicPlayer &) = delete;
+    MusicPlayer &operator=(const MusicPlayer &) = delete;
+
+    // Registers a loaded stream; once started, it goes to the audio thread like the other
+    // commands, so a track can be opened only when it is about to play. Returns its track number.
+    int add(Music music) {
+        if (running.load(std::memory_order_relaxed)) commands.push({CommandType::Add, trackCount, music});
+        else tracks.push_back(music);
+        return trackCount++;
+    }
+
+    // Starts the audio thread. The tracks belong to it until shutdown().
+    void start() {
+        running.store(true, std::memory_order_release);
+#if !defined(PLATFORM_WEB)
+        worker = std::thread(&MusicPlayer::run, this);
+#endif
+    }
+
+    // Does the audio thread's work on the calling thread when there is no audio thread (the browser)
+    void update() {
+        if (running.load(std::memory_order_relaxed) && !worker.joinable()) service();
+    }
+
+    // Stops the audio thread, after which the tracks can be unloaded
+    void shutdown() {
+        running.store(false, std::memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
+
+    // Starts a track from the beginning. A negative track (one still loading) is ignored.
+    void play(int track) {
+        if (track >= 0) commands.push({CommandType::Play, track, Music()});
+    }
+
+    // Stops a track and rewinds it. A negative track is ignored.
+    void stop(int track) {
+        if (track >= 0) commands.push({CommandType::Stop, track, Music()});
+    }
+};
+
+#endif // MUSIC_PLAYER_H
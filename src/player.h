@@ -0,0 +1,62 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include "raylib.h"
+#include "sprite_atlas.h"
+
+const int MOVE_COOLDOWN_TICKS = 12;     // Ticks between two moves (0.2 s at 60 ticks per second)
+
+/// Player class definition
+class Player {
+private:
+    int x, y;                    // Player's current position in the maze
+    int previousX, previousY;    // Position at the previous tick, drawing interpolates from there
+    int cellSize;               // Size of the player's representation (same as maze cell size)
+    int moveCooldown;           // Minimum number of ticks between two moves
+    int ticksUntilMove;         // Ticks left before the next move is allowed
+
+public:
+    // Constructor to initialize player's starting position, cell size, and movement properties
+    Player(int startX, int startY, int size) 
+        : x(startX), y(startY), previousX(startX), previousY(startY), cellSize(size),
+          moveCooldown(MOVE_COOLDOWN_TICKS), ticksUntilMove(0) {}
+
+    // Advances the player by one simulation tick with the held direction, considering
+    // the cooldown and walls. Vertical input wins when both axes are held.
+    // Works with any maze exposing isWall (Maze or ChunkedMaze). Returns whether the player moved.
+    template <typename MazeType>
+    bool tick(int dx, int dy, const MazeType &maze) {
+        previousX = x;
+        previousY = y;
+        if (ticksUntilMove > 0) ticksUntilMove--;
+        if (ticksUntilMove > 0 || (dx == 0 && dy == 0)) return false; // Cooldown running or nothing held
+
+        if (dy != 0) dx = 0; // One axis per move
+        int newX = x + dx; // Proposed new X position
+        int newY = y + dy; // Proposed new Y position
+        ticksUntilMove = moveCooldown; // Restart the cooldown, even against a wall
+        if (maze.isWall(newX, newY)) return false; // Check if the move leads to a non-wall cell
+        x = newX; // Move the player to the new position
+        y = newY;
+        return true;
+    }
+
+    // Position in cells between the previous and the current tick, alpha in [0, 1]
+    Vector2 getDrawPosition(float alpha) const {
+        return {previousX + (x - previousX) * alpha, previousY + (y - previousY) * alpha};
+    }
+
+    // Draws the player character at its interpolated position
+    void draw(const SpriteFrame &character, float alpha) const {
+        Vector2 position = getDrawPosition(alpha);
+        drawSpriteScaled(character, {position.x * cellSize, position.y * cellSize}, (float)cellSize, WHITE);
+    }
+
+    // Getter to access the player's current X coordinate
+    int getX() const { return x; }
+
+    // Getter to access the player's current Y coordinate
+    int getY() const { return y; }
+};
+
+#endif // PLAYER_H
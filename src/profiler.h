@@ -0,0 +1,228 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raylib.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Stages of a frame timed by the profiler. Frame covers a whole main loop iteration.
+enum class ProfileStage { Input, Update, Menu, Maze, Player, Present, Frame };
+const int PROFILE_STAGE_COUNT = 7;
+const int PROFILE_HISTORY = 4096;       // Frames kept, a bit over a minute at 60 FPS
+const int PROFILE_GRAPH_FRAMES = 240;   // Frames shown in the rolling graph
+const int PROFILE_STARTUP_PHASES = 16;  // Startup phases kept
+
+// FrameProfiler class definition
+// Times the stages of every frame into a ring buffer allocated once up front, so
+// profiling never allocates while the game runs. Shows an overlay with the
+// p50/p95/p99 time of each stage and a graph of the recent frame times, and can
+// write the buffered frames as a Chrome trace (chrome://tracing, Perfetto).
+// It also keeps the phases of the game's startup, timed from the profiler's own
+// creation (first thing in main), some of which finish behind the first frames.
+class FrameProfiler {
+private:
+    // Time spent in one stage during one frame, in microseconds since the profiler started
+    struct Sample {
+        double start;                    // When the stage first ran in the frame
+        float duration;                  // Total time in the stage, negative if it did not run
+    };
+
+    struct Frame {
+        Sample stages[PROFILE_STAGE_COUNT];
+    };
+
+    struct StartupPhase {
+        const char *name;                // Static string
+        double start;                    // Microseconds since the profiler started
+        float duration;
+    };
+
+    std::chrono::steady_clock::time_point origin; // Time zero of every timestamp
+    std::vector<Frame> frames;           // Ring buffer of the last PROFILE_HISTORY frames
+    double openStart[PROFILE_STAGE_COUNT]; // Start of the stages currently running
+    uint64_t frameCount;                 // Frames begun so far
+    bool overlayVisible;                 // Whether the overlay is drawn
+    mutable std::vector<float> scratch;  // Sort buffer for the percentiles, sized once
+    std::vector<StartupPhase> startupPhases; // In the order they finished, up to PROFILE_STARTUP_PHASES
+
+    double now() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    Frame &currentFrame() { return frames[(frameCount - 1) % PROFILE_HISTORY]; }
+
+    // Number of finished frames still in the buffer (the current one is still being timed)
+    int completedFrames() const {
+        return (int)std::min<uint64_t>(frameCount > 0 ? frameCount - 1 : 0, PROFILE_HISTORY - 1);
+    }
+
+    // Finished frame i, 0 being the oldest still buffered
+    const Frame &completedFrame(int i) const {
+        return frames[(frameCount - 1 - completedFrames() + i) % PROFILE_HISTORY];
+    }
+
+    static const char *stageName(int stage) {
+        static const char *names[PROFILE_STAGE_COUNT] = {"Input", "Update", "Menu", "Maze",
+                                                         "Player", "Present", "Frame"};
+        return names[stage];
+    }
+
+public:
+    FrameProfiler()
+        : origin(std::chrono::steady_clock::now()), frames(PROFILE_HISTORY), frameCount(0), overlayVisible(false),
+          scratch(PROFILE_HISTORY) {
+        std::fill(openStart, openStart + PROFILE_STAGE_COUNT, 0.0);
+        startupPhases.reserve(PROFILE_STARTUP_PHASES);
+    }
+
+    // Microseconds since the profiler started, the start to give recordStartup()
+    double timestamp() const { return now(); }
+
+    // Records a startup phase that began at start (a timestamp()) and ends now. name must be a static string.
+    void recordStartup(const char *name, double start) {
+        if (startupPhases.size() < (size_t)PROFILE_STARTUP_PHASES) startupPhases.push_back({name, start, (float)(now() - start)});
+    }
+
+    // Starts timing a new frame, closing the previous one
+    void beginFrame() {
+        double time = now();
+        if (frameCount > 0) {
+            Sample &frame = currentFrame().stages[(int)ProfileStage::Frame];
+            frame.duration = (float)(time - frame.start);
+        }
+        frameCount++;
+        for (Sample &sample : currentFrame().stages) sample = {time, -1.0f};
+        currentFrame().stages[(int)ProfileStage::Frame].start = time;
+    }
+
+    void begin(ProfileStage stage) {
+        openStart[(int)stage] = now();
+    }
+
+    // Ends a stage. A stage running several times in a frame adds up.
+    void end(ProfileStage stage) {
+        if (frameCount == 0) return;
+        double start = openStart[(int)stage];
+        float elapsed = (float)(now() - start);
+        Sample &sample = currentFrame().stages[(int)stage];
+        if (sample.duration < 0) sample = {start, elapsed};
+        else sample.duration += elapsed;
+    }
+
+    void toggleOverlay() { overlayVisible = !overlayVisible; }
+
+    // p50, p95 and p99 of a stage in milliseconds over the buffered frames it ran in. Returns false if it never ran.
+    bool percentiles(ProfileStage stage, float &p50, float &p95, float &p99) const {
+        int count = 0;
+        for (int i = 0; i < completedFrames(); i++) {
+            float duration = completedFrame(i).stages[(int)stage].duration;
+            if (duration >= 0) scratch[count++] = duration;
+        }
+        if (count == 0) return false;
+        std::sort(scratch.begin(), scratch.begin() + count);
+        p50 = scratch[(count - 1) * 50 / 100] / 1000.0f;
+        p95 = scratch[(count - 1) * 95 / 100] / 1000.0f;
+        p99 = scratch[(count - 1) * 99 / 100] / 1000.0f;
+        return true;
+    }
+
+    // Draws the overlay in screen space with its top-left corner at (x, y)
+    void drawOverlay(int x, int y) const {
+        if (!overlayVisible) return;
+        const int lineHeight = 22, graphHeight = 100;
+        const int width = 460, graphTop = 40 + PROFILE_STAGE_COUNT * lineHeight;
+        const int startupHeight = startupPhases.empty() ? 0 : 30 + (int)startupPhases.size() * lineHeight;
+        const int height = graphTop + graphHeight + 20 + startupHeight;
+        DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+        DrawText(TextFormat("%d FPS    p50     p95     p99 (ms)", GetFPS()), x + 10, y + 10, 20, WHITE);
+
+        for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+            int lineY = y + 40 + stage * lineHeight;
+            float p50, p95, p99;
+            DrawText(stageName(stage), x + 10, lineY, 20, LIGHTGRAY);
+            if (percentiles((ProfileStage)stage, p50, p95, p99)) {
+                DrawText(TextFormat("%6.2f  %6.2f  %6.2f", p50, p95, p99), x + 130, lineY, 20, WHITE);
+            }
+        }
+
+        // Rolling graph of the frame times, with the 60 and 30 FPS budgets marked
+        int graphBottom = y + graphTop + graphHeight + 10;
+        float pixelsPerMs = graphHeight / 40.0f;
+        DrawLine(x + 10, graphBottom - (int)(16.7f * pixelsPerMs), x + width - 10,
+                 graphBottom - (int)(16.7f * pixelsPerMs), GREEN);
+        DrawLine(x + 10, graphBottom - (int)(33.3f * pixelsPerMs), x + width - 10,
+                 graphBottom - (int)(33.3f * pixelsPerMs), ORANGE);
+
+        int shown = std::min(completedFrames(), PROFILE_GRAPH_FRAMES);
+        float barWidth = (float)(width - 20) / PROFILE_GRAPH_FRAMES;
+        for (int i = 0; i < shown; i++) {
+            float ms = completedFrame(completedFrames() - shown + i).stages[(int)ProfileStage::Frame].duration / 1000.0f;
+            float barHeight = std::min(ms * pixelsPerMs, (float)graphHeight);
+            Color color = (ms > 33.3f) ? RED : (ms > 16.7f) ? ORANGE : SKYBLUE;
+            DrawRectangleV({x + 10 + i * barWidth, graphBottom - barHeight}, {std::max(barWidth, 1.0f), barHeight}, color);
+        }
+
+        // Startup phases: when each ended after launch, and how long it took
+        if (startupPhases.empty()) return;
+        int startupY = graphBottom + 10;
+        DrawText("Startup         ends at   took (ms)", x + 10, startupY, 20, WHITE);
+        for (size_t i = 0; i < startupPhases.size(); i++) {
+            const StartupPhase &phase = startupPhases[i];
+            int lineY = startupY + 30 + (int)i * lineHeight;
+            DrawText(phase.name, x + 10, lineY, 20, LIGHTGRAY);
+            DrawText(TextFormat("%8.1f  %8.1f", (phase.start + phase.duration) / 1000.0, phase.duration / 1000.0f),
+                     x + 190, lineY, 20, WHITE);
+        }
+    }
+
+    // Writes the buffered frames as a Chrome trace JSON file. Returns false if the file cannot be written.
+    bool writeChromeTrace(const char *path) const {
+        FILE *file = fopen(path, "w");
+        if (!file) return false;
+
+        fprintf(file, "{\"traceEvents\": [\n");
+        bool first = true;
+        for (const StartupPhase &phase : startupPhases) { // On their own track, they overlap the first frames
+            fprintf(file, "%s  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f}",
+                    first ? "" : ",\n", phase.name, phase.start, phase.duration);
+            first = false;
+        }
+        for (int i = 0; i < completedFrames(); i++) {
+            const Frame &frame = completedFrame(i);
+            for (int stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+                const Sample &sample = frame.stages[stage];
+                if (sample.duration < 0) continue;
+                // Frames and stages go on separate tracks so the stages never overlap their frame
+                fprintf(file, "%s  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                        first ? "" : ",\n", stageName(stage), stage == (int)ProfileStage::Frame ? 1 : 2,
+                        sample.start, sample.duration);
+                first = false;
+            }
+        }
+        fprintf(file, "\n], \"displayTimeUnit\": \"ms\"}\n");
+        return fclose(file) == 0;
+    }
+};
+
+// Times a stage for as long as the scope is alive
+class ProfileScope {
+private:
+    FrameProfiler &profiler;
+    ProfileStage stage;
+
+public:
+    ProfileScope(FrameProfiler &frameProfiler, ProfileStage profiledStage)
+        : profiler(frameProfiler), stage(profiledStage) {
+        profiler.begin(stage);
+    }
+
+    ~ProfileScope() { profiler.end(stage); }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#endif // PROFILER_H
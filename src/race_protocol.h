@@ -0,0 +1,284 @@
+#ifndef RACE_PROTOCOL_H
+#define RACE_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Race mode wire format. A packet is one UDP datagram starting with its RacePacket
+// type byte, the other fields little-endian:
+//   Hello     client -> server   magic u32, version u16
+//   Welcome   server -> client   slot u8, seed u64, width u32, height u32, algorithm u8, tick u32
+//   Full      server -> client   nothing, every slot is taken
+//   Intent    client -> server   snapshot u16, last u16, count u8, count intents packed two per byte
+//   Snapshot  server -> client   tick u16, base age u8, ack u16, present u8, finished u8, changed u8,
+//                                then a delta per changed player
+// The maze never goes over the wire: both ends generate it from the seed and dimensions.
+//
+// An intent is the direction a client held on one of its ticks, numbered from 1 (4 bits:
+// 0 for none, then up, down, left, right). Each intent packet repeats the last few not yet
+// acknowledged, so a lost datagram costs nothing, and acknowledges the newest snapshot.
+//
+// A snapshot holds everybody's position after a server tick, as a delta against the
+// snapshot the client acknowledged last (base age ticks older, 0 for a delta against all
+// zeros). ack is the client's last intent the server applied. A changed player takes one
+// byte, dx in the low nibble and dy in the high one (-7..7), or the escape 0x88 followed by
+// the absolute x u16 and y u16. A moving player costs a byte, a standing one nothing.
+//
+// 16-bit ticks and sequence numbers are the low bits of 32-bit counters, extended by the
+// receiver from the ones it already has (extendCounter).
+const uint32_t RACE_PROTOCOL_MAGIC = 0x43525A4D; // "MZRC"
+const uint16_t RACE_PROTOCOL_VERSION = 1;
+const int RACE_MAX_PLAYERS = 8;         // Slots of a race, one bit each in the snapshot masks
+const int RACE_MAX_REDUNDANCY = 8;      // Most intents an intent packet carries
+const int RACE_MAX_PACKET = 64;         // Largest packet of the protocol, in bytes
+const int RACE_MAX_SIDE = 1024;         // Largest maze a host serves (one screen of 30-pixel cells is 256 on 8K)
+const uint8_t RACE_DELTA_ESCAPE = 0x88; // Delta byte announcing absolute coordinates (-8 is not a delta)
+
+enum class RacePacket : uint8_t { Hello = 1, Welcome, Full, Intent, Snapshot };
+
+// Maze and slot given to a client that joins
+struct RaceWelcome {
+    uint8_t slot;                        // Slot of the client, its bit in the snapshot masks
+    uint64_t seed;                       // Seed of the maze
+    uint32_t width, height;              // Dimensions of the maze in cells
+    uint8_t algorithm;                   // MazeAlgorithm the maze was carved with
+    uint32_t tick;                       // Server tick the client joined on
+};
+
+// The intents of an intent packet
+struct RaceIntents {
+    uint16_t snapshot;                   // Newest snapshot the client received
+    uint16_t last;                       // Sequence number of the last intent carried
+    int count;                           // Intents carried, ending with last
+    uint8_t intents[RACE_MAX_REDUNDANCY]; // Oldest first
+};
+
+// Everybody's position after a server tick
+struct RaceState {
+    uint32_t tick;
+    uint8_t present, finished;           // Masks of the slots taken and of the players on the exit
+    uint16_t x[RACE_MAX_PLAYERS], y[RACE_MAX_PLAYERS]; // Positions, zero in the slots not taken
+};
+
+// Fields of a snapshot before its deltas
+struct RaceSnapshotHeader {
+    uint16_t tick;                       // Server tick of the snapshot
+    uint8_t baseAge;                     // Ticks back to the state the deltas apply to, 0 for none
+    uint16_t ack;                        // Last intent of the receiver the server applied
+};
+
+// Extends the low 16 bits of a counter to the value closest to reference. Compare the
+// result with signed differences: a value just below a small reference wraps around.
+inline uint32_t extendCounter(uint16_t low, uint32_t reference) {
+    return reference + (int16_t)(uint16_t)(low - (uint16_t)reference);
+}
+
+// Intent of a held direction, vertical first like Player::tick
+inline uint8_t raceIntent(int dx, int dy) {
+    return dy < 0 ? 1 : dy > 0 ? 2 : dx < 0 ? 3 : dx > 0 ? 4 : 0;
+}
+
+// Direction of an intent, nothing for an unknown one
+inline void raceIntentStep(uint8_t intent, int &dx, int &dy) {
+    static const int stepX[5] = {0, 0, 0, -1, 1};
+    static const int stepY[5] = {0, -1, 1, 0, 0};
+    if (intent > 4) intent = 0;
+    dx = stepX[intent];
+    dy = stepY[intent];
+}
+
+// RaceWriter class definition
+// Appends little-endian fields to a packet buffer of RACE_MAX_PACKET bytes
+class RaceWriter {
+private:
+    uint8_t *start, *position;
+
+public:
+    explicit RaceWriter(uint8_t *packet) : start(packet), position(packet) {}
+
+    void u8(uint8_t value) { *position++ = value; }
+    void u16(uint16_t value) {
+        u8((uint8_t)value);
+        u8((uint8_t)(value >> 8));
+    }
+    void u32(uint32_t value) {
+        u16((uint16_t)value);
+        u16((uint16_t)(value >> 16));
+    }
+    void u64(uint64_t value) {
+        u32((uint32_t)value);
+        u32((uint32_t)(value >> 32));
+    }
+
+    size_t size() const { return (size_t)(position - start); }
+};
+
+// RaceReader class definition
+// Reads little-endian fields from a received packet. Reading past its end yields zeros
+// and clears ok(), so a packet is checked once after all its fields are read.
+class RaceReader {
+private:
+    const uint8_t *position, *end;
+    bool valid;
+
+public:
+    RaceReader(const uint8_t *packet, size_t size) : position(packet), end(packet + size), valid(true) {}
+
+    uint8_t u8() {
+        if (position == end) {
+            valid = false;
+            return 0;
+        }
+        return *position++;
+    }
+    uint16_t u16() {
+        uint16_t low = u8();
+        return (uint16_t)(low | (u8() << 8));
+    }
+    uint32_t u32() {
+        uint32_t low = u16();
+        return low | ((uint32_t)u16() << 16);
+    }
+    uint64_t u64() {
+        uint64_t low = u32();
+        return low | ((uint64_t)u32() << 32);
+    }
+
+    bool ok() const { return valid; }
+    bool atEnd() const { return position == end; }
+};
+
+inline size_t writeHello(uint8_t *packet) {
+    RaceWriter out(packet);
+    out.u8((uint8_t)RacePacket::Hello);
+    out.u32(RACE_PROTOCOL_MAGIC);
+    out.u16(RACE_PROTOCOL_VERSION);
+    return out.size();
+}
+
+// Reads a Hello after its type byte. Returns false for another game or version.
+inline bool readHello(RaceReader &in) {
+    uint32_t magic = in.u32();
+    uint16_t version = in.u16();
+    return in.ok() && magic == RACE_PROTOCOL_MAGIC && version == RACE_PROTOCOL_VERSION;
+}
+
+inline size_t writeWelcome(uint8_t *packet, const RaceWelcome &welcome) {
+    RaceWriter out(packet);
+    out.u8((uint8_t)RacePacket::Welcome);
+    out.u8(welcome.slot);
+    out.u64(welcome.seed);
+    out.u32(welcome.width);
+    out.u32(welcome.height);
+    out.u8(welcome.algorithm);
+    out.u32(welcome.tick);
+    return out.size();
+}
+
+// Reads a Welcome after its type byte. Returns false if it is truncated or out of range.
+inline bool readWelcome(RaceReader &in, RaceWelcome &welcome) {
+    welcome.slot = in.u8();
+    welcome.seed = in.u64();
+    welcome.width = in.u32();
+    welcome.height = in.u32();
+    welcome.algorithm = in.u8();
+    welcome.tick = in.u32();
+    return in.ok() && welcome.slot < RACE_MAX_PLAYERS && welcome.width >= 3 && welcome.height >= 3 &&
+           welcome.width <= (uint32_t)RACE_MAX_SIDE && welcome.height <= (uint32_t)RACE_MAX_SIDE;
+}
+
+inline size_t writeFull(uint8_t *packet) {
+    packet[0] = (uint8_t)RacePacket::Full;
+    return 1;
+}
+
+// Writes the count intents ending with sequence number last (0 intents keeps the slot alive)
+inline size_t writeIntents(uint8_t *packet, uint32_t snapshot, uint32_t last, const uint8_t *intents, int count) {
+    RaceWriter out(packet);
+    out.u8((uint8_t)RacePacket::Intent);
+    out.u16((uint16_t)snapshot);
+    out.u16((uint16_t)last);
+    out.u8((uint8_t)count);
+    for (int i = 0; i < count; i += 2) {
+        out.u8((uint8_t)((intents[i] & 15) | (i + 1 < count ? (intents[i + 1] & 15) << 4 : 0)));
+    }
+    return out.size();
+}
+
+// Reads an intent packet after its type byte
+inline bool readIntents(RaceReader &in, RaceIntents &intents) {
+    intents.snapshot = in.u16();
+    intents.last = in.u16();
+    intents.count = in.u8();
+    if (intents.count > RACE_MAX_REDUNDANCY) return false;
+    for (int i = 0; i < intents.count; i += 2) {
+        uint8_t pair = in.u8();
+        intents.intents[i] = pair & 15;
+        if (i + 1 < intents.count) intents.intents[i + 1] = pair >> 4;
+    }
+    return in.ok() && in.atEnd();
+}
+
+// Writes state as a delta against base, which is baseAge ticks older (an all-zero state for 0)
+inline size_t writeSnapshot(uint8_t *packet, const RaceState &state, const RaceState &base, uint8_t baseAge,
+                            uint32_t ack) {
+    RaceWriter out(packet);
+    out.u8((uint8_t)RacePacket::Snapshot);
+    out.u16((uint16_t)state.tick);
+    out.u8(baseAge);
+    out.u16((uint16_t)ack);
+    out.u8(state.present);
+    out.u8(state.finished);
+    uint8_t changed = 0;
+    for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+        if (((state.present >> i) & 1) && (state.x[i] != base.x[i] || state.y[i] != base.y[i])) changed |= 1 << i;
+    }
+    out.u8(changed);
+    for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+        if (!((changed >> i) & 1)) continue;
+        int dx = state.x[i] - base.x[i], dy = state.y[i] - base.y[i];
+        if (dx >= -7 && dx <= 7 && dy >= -7 && dy <= 7) {
+            out.u8((uint8_t)((dx & 15) | ((dy & 15) << 4)));
+        } else {
+            out.u8(RACE_DELTA_ESCAPE);
+            out.u16(state.x[i]);
+            out.u16(state.y[i]);
+        }
+    }
+    return out.size();
+}
+
+// Reads the fields of a snapshot after its type byte, up to its deltas
+inline bool readSnapshotHeader(RaceReader &in, RaceSnapshotHeader &header) {
+    header.tick = in.u16();
+    header.baseAge = in.u8();
+    header.ack = in.u16();
+    return in.ok();
+}
+
+// Reads the rest of a snapshot into state, applying its deltas to base (the state
+// header.baseAge ticks older, or an all-zero state). state.tick is left to the caller.
+inline bool readSnapshotBody(RaceReader &in, const RaceState &base, RaceState &state) {
+    state.present = in.u8();
+    state.finished = in.u8();
+    uint8_t changed = in.u8();
+    if ((changed & ~state.present) || (state.finished & ~state.present)) return false;
+    for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+        state.x[i] = state.y[i] = 0;
+        if (!((state.present >> i) & 1)) continue;
+        state.x[i] = base.x[i];
+        state.y[i] = base.y[i];
+        if (!((changed >> i) & 1)) continue;
+        uint8_t delta = in.u8();
+        if (delta == RACE_DELTA_ESCAPE) {
+            state.x[i] = in.u16();
+            state.y[i] = in.u16();
+        } else {
+            state.x[i] = (uint16_t)(state.x[i] + ((int8_t)(uint8_t)(delta << 4) >> 4)); // Sign-extends the low nibble
+            state.y[i] = (uint16_t)(state.y[i] + ((int8_t)delta >> 4));
+        }
+    }
+    return in.ok() && in.atEnd();
+}
+
+#endif // RACE_PROTOCOL_H
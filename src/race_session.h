@@ -0,0 +1,391 @@
+#ifndef RACE_SESSION_H
+#define RACE_SESSION_H
+
+#include "maze.h"
+#include "player.h"
+#include "race_protocol.h"
+#include "race_socket.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+const uint16_t RACE_DEFAULT_PORT = 47100;
+const int RACE_HISTORY = 64;            // Ticks of states kept by both ends as delta bases (about a second)
+const int RACE_INTENT_BUFFER = 64;      // Intents kept by sequence number, the most a client runs ahead
+const int RACE_INTENT_REDUNDANCY = 4;   // Latest unacknowledged intents repeated in every intent packet
+const int RACE_INTENT_LEAD = 30;        // Intents a client may be ahead of the server clock (0.5 s)
+const uint32_t RACE_TIMEOUT_TICKS = 300; // Server ticks of silence before a slot is freed (5 s)
+const int RACE_RESEND_TICKS = 30;       // Client updates between two hellos, or keepalives before the start
+
+static_assert(RACE_INTENT_REDUNDANCY <= RACE_MAX_REDUNDANCY, "Intent packets carry at most RACE_MAX_REDUNDANCY");
+static_assert(RACE_HISTORY < 256, "The age of a delta base is sent in a byte");
+
+// RaceServer class definition
+// Authoritative side of a race: every racer is a Player simulated here with the
+// same rules as a local game, fed only with the intents its client sends. After
+// each tick everybody's position goes to every client in one snapshot, delta
+// compressed against the last snapshot that client acknowledged. The host of a
+// race runs one and joins it through the loopback like any other client.
+class RaceServer {
+private:
+    struct Slot {
+        bool connected;
+        NetAddress address;
+        Player player;                   // The position that counts
+        uint32_t nextIntent;             // Sequence number of the next intent to apply
+        uint32_t newestIntent;           // Highest sequence number received
+        uint32_t intentSeqs[RACE_INTENT_BUFFER]; // Sequence number held by each entry of intents
+        uint8_t intents[RACE_INTENT_BUFFER]; // Received intents, by sequence number
+        uint32_t startTick;              // Tick the first intent came on, 0 before; the slot's clock
+        uint32_t ackedTick;              // Newest snapshot the client has, 0 for none
+        uint32_t joinTick;               // Tick of the welcome, the oldest snapshot the client can have
+        uint32_t lastHeard;              // Tick of the last packet from the client
+
+        explicit Slot(const Player &start)
+            : connected(false), address(), player(start), nextIntent(1), newestIntent(0), intentSeqs(), intents(),
+              startTick(0), ackedTick(0), joinTick(0), lastHeard(0) {}
+    };
+
+    Maze maze;                           // Generated from the seed like on the clients, never drawn
+    UdpSocket socket;
+    std::vector<Slot> slots;             // RACE_MAX_PLAYERS slots
+    RaceState history[RACE_HISTORY];     // States of the last ticks, by tick
+    const RaceState empty;               // Base of a snapshot to a client without one
+    uint32_t tick;                       // Ticks since the server started
+
+    int findSlot(const NetAddress &address) const {
+        for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+            if (slots[i].connected && slots[i].address == address) return i;
+        }
+        return -1;
+    }
+
+    // Takes the first free slot for a new client, -1 when the race is full
+    int join(const NetAddress &address) {
+        for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+            if (slots[i].connected) continue;
+            slots[i] = Slot(Player(1, 1, 1));
+            slots[i].connected = true;
+            slots[i].address = address;
+            slots[i].joinTick = tick;
+            slots[i].lastHeard = tick;
+            return i;
+        }
+        return -1;
+    }
+
+    // Stores the intents of a packet and the snapshot it acknowledges. A snapshot from
+    // before the join is one the client has none of yet.
+    void receiveIntents(Slot &slot, const RaceIntents &packet) {
+        uint32_t acked = extendCounter(packet.snapshot, tick);
+        if ((int32_t)(acked - slot.ackedTick) > 0 && (int32_t)(tick - acked) >= 0 &&
+            (int32_t)(acked - slot.joinTick) >= 0) {
+            slot.ackedTick = acked;
+        }
+        if (packet.count == 0) return;
+        if (slot.startTick == 0) slot.startTick = tick - 1;
+
+        uint32_t last = extendCounter(packet.last, slot.nextIntent);
+        for (int i = 0; i < packet.count; i++) {
+            uint32_t seq = last - (packet.count - 1 - i);
+            // Already applied, or so far ahead that it would overwrite one still waiting
+            if ((int32_t)(seq - slot.nextIntent) < 0 || seq - slot.nextIntent >= (uint32_t)RACE_INTENT_BUFFER) continue;
+            slot.intentSeqs[seq % RACE_INTENT_BUFFER] = seq;
+            slot.intents[seq % RACE_INTENT_BUFFER] = packet.intents[i];
+            if ((int32_t)(seq - slot.newestIntent) > 0) slot.newestIntent = seq;
+        }
+    }
+
+    // Reads every waiting packet
+    void receive() {
+        uint8_t packet[RACE_MAX_PACKET];
+        NetAddress from;
+        int size;
+        while ((size = socket.receive(packet, sizeof(packet), from)) >= 0) {
+            RaceReader in(packet, (size_t)size);
+            RacePacket type = (RacePacket)in.u8();
+            int index = findSlot(from);
+            if (type == RacePacket::Hello && readHello(in)) {
+                if (index < 0) index = join(from);
+                uint8_t reply[RACE_MAX_PACKET];
+                if (index < 0) {
+                    socket.send(from, reply, writeFull(reply));
+                    continue;
+                }
+                // Sent again for every hello, the client repeats its hello until one arrives
+                RaceWelcome welcome = {(uint8_t)index, maze.getSeed(), (uint32_t)maze.getWidth(),
+                                       (uint32_t)maze.getHeight(), (uint8_t)maze.getAlgorithm(), tick};
+                socket.send(from, reply, writeWelcome(reply, welcome));
+                slots[index].lastHeard = tick;
+            } else if (type == RacePacket::Intent && index >= 0) {
+                RaceIntents intents;
+                if (!readIntents(in, intents)) continue;
+                receiveIntents(slots[index], intents);
+                slots[index].lastHeard = tick;
+            }
+        }
+    }
+
+    // Applies the intents of a slot that are in, in order, as far as its clock allows
+    void advance(Slot &slot) {
+        if (slot.startTick == 0) return;
+        uint32_t limit = tick - slot.startTick + RACE_INTENT_LEAD; // Faster than the clock would be a speed hack
+        while ((int32_t)(limit - slot.nextIntent) >= 0) {
+            uint8_t intent = 0;
+            int index = slot.nextIntent % RACE_INTENT_BUFFER;
+            if (slot.intentSeqs[index] == slot.nextIntent) {
+                intent = slot.intents[index];
+            } else if ((int32_t)(slot.newestIntent - slot.nextIntent) < RACE_INTENT_REDUNDANCY) {
+                break; // May still come with the next packet
+            } // Otherwise every packet that carried it was lost: the tick goes without input
+            int dx, dy;
+            raceIntentStep(intent, dx, dy);
+            if (maze.isExit(slot.player.getX(), slot.player.getY())) dx = dy = 0; // Done racing
+            slot.player.tick(dx, dy, maze);
+            slot.nextIntent++;
+        }
+    }
+
+public:
+    // Generates the race maze. Nothing is sent before open().
+    RaceServer(int width, int height, uint64_t seed, MazeAlgorithm algorithm = MazeAlgorithm::DFS)
+        : maze(std::min(width, RACE_MAX_SIDE), std::min(height, RACE_MAX_SIDE), 1, BLACK, Texture2D{}, seed, algorithm),
+          slots(RACE_MAX_PLAYERS, Slot(Player(1, 1, 1))), history(), empty(), tick(0) {}
+
+    // Starts listening for clients. Returns false if the port is taken (or on the web).
+    bool open(uint16_t port) { return socket.open(port); }
+
+    // One server tick: reads the waiting packets, applies the intents they brought and sends
+    // every client the new positions. Call it at the simulation rate, in or out of a level.
+    void update() {
+        tick++;
+        receive();
+
+        RaceState &state = history[tick % RACE_HISTORY];
+        state = RaceState();
+        state.tick = tick;
+        for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+            Slot &slot = slots[i];
+            if (slot.connected && tick - slot.lastHeard > RACE_TIMEOUT_TICKS) slot.connected = false;
+            if (!slot.connected) continue;
+            advance(slot);
+            state.present |= 1 << i;
+            if (maze.isExit(slot.player.getX(), slot.player.getY())) state.finished |= 1 << i;
+            state.x[i] = (uint16_t)slot.player.getX();
+            state.y[i] = (uint16_t)slot.player.getY();
+        }
+
+        // One packet per client, with its own base and ack
+        for (Slot &slot : slots) {
+            if (!slot.connected) continue;
+            const RaceState *base = &empty;
+            uint32_t age = tick - slot.ackedTick;
+            if (slot.ackedTick != 0 && age < (uint32_t)RACE_HISTORY && history[slot.ackedTick % RACE_HISTORY].tick ==
+                                                                           slot.ackedTick) {
+                base = &history[slot.ackedTick % RACE_HISTORY];
+            } else {
+                age = 0;
+            }
+            uint8_t packet[RACE_MAX_PACKET];
+            socket.send(slot.address, packet, writeSnapshot(packet, state, *base, (uint8_t)age, slot.nextIntent - 1));
+        }
+    }
+
+    int getPlayerCount() const {
+        int count = 0;
+        for (const Slot &slot : slots) count += slot.connected;
+        return count;
+    }
+};
+
+// What a race client is doing
+enum class RaceClientState {
+    Joining,                             // Sending hellos until the server answers
+    Joined,                              // The maze is known, the race starts with start()
+    Racing,                              // Predicting and sending intents
+    Refused                              // The race is full
+};
+
+// RaceClient class definition
+// Player side of a race. Only the held direction of every tick goes to the server;
+// the player moves at once on the client's own copy of the maze (generated from the
+// seed in the welcome), and the server's answer only confirms it. The server runs the
+// same Player::tick on the same walls, so the two agree unless intents were lost for
+// good, and then the prediction restarts from the server's position.
+class RaceClient {
+private:
+    UdpSocket socket;
+    NetAddress server;
+    RaceClientState state;
+    RaceWelcome welcome;                 // Maze and slot, once Joined
+    const Maze *maze;                    // Walls the moves are predicted against, set by start()
+
+    Player player;                       // Predicted local player
+    int cellSize;                        // Cell size of the maze, for the players rebuilt by reconcile()
+    uint32_t lastIntent;                 // Sequence number of the newest intent
+    uint32_t confirmedIntent;            // Newest intent the server said it applied
+    uint8_t intents[RACE_INTENT_BUFFER]; // Intents sent, by sequence number
+    std::vector<Player> predicted;       // Player after each intent, by sequence number
+
+    RaceState states[RACE_HISTORY];      // Received states by tick, the delta bases
+    RaceState previous, latest;          // The last two received, opponents are drawn between them
+    const RaceState empty;
+    uint8_t finishOrder[RACE_MAX_PLAYERS]; // Slots in the order they reached the exit
+    int finishedCount;
+    int resendCountdown;                 // Updates until the next hello or keepalive
+    uint64_t snapshotBytes, snapshotCount; // Received snapshot traffic, for the bandwidth readout
+
+    // Tick of the newest stored snapshot, acknowledged to the server and the reference of
+    // the 16-bit snapshot ticks. Before the first one it is the tick before the welcome,
+    // which the server does not take as an acknowledgement.
+    uint32_t newestTick() const { return snapshotCount ? latest.tick : welcome.tick - 1; }
+
+    void sendIntents(int count) {
+        uint8_t packet[RACE_MAX_PACKET];
+        uint8_t carried[RACE_MAX_REDUNDANCY];
+        for (int i = 0; i < count; i++) carried[i] = intents[(lastIntent - (count - 1 - i)) % RACE_INTENT_BUFFER];
+        socket.send(server, packet, writeIntents(packet, newestTick(), lastIntent, carried, count));
+    }
+
+    // Checks the prediction at the intent the server confirmed against where the server put the player
+    void reconcile(uint32_t ack) {
+        if (state != RaceClientState::Racing || (int32_t)(ack - confirmedIntent) <= 0 ||
+            (int32_t)(lastIntent - ack) < 0 || lastIntent - ack >= (uint32_t)RACE_INTENT_BUFFER) {
+            return;
+        }
+        confirmedIntent = ack;
+        int x = latest.x[welcome.slot], y = latest.y[welcome.slot];
+        const Player &then = predicted[ack % RACE_INTENT_BUFFER];
+        if (then.getX() == x && then.getY() == y) return;
+
+        // Mispredicted: start again from the server's position and replay the newer intents
+        Player replayed(x, y, cellSize);
+        for (uint32_t seq = ack + 1; seq != lastIntent + 1; seq++) {
+            int dx, dy;
+            raceIntentStep(intents[seq % RACE_INTENT_BUFFER], dx, dy);
+            if (maze->isExit(replayed.getX(), replayed.getY())) dx = dy = 0;
+            replayed.tick(dx, dy, *maze);
+            predicted[seq % RACE_INTENT_BUFFER] = replayed;
+        }
+        player = replayed;
+    }
+
+    void receiveSnapshot(RaceReader &in, size_t size) {
+        RaceSnapshotHeader header;
+        if (!readSnapshotHeader(in, header)) return;
+        uint32_t tick = extendCounter(header.tick, newestTick());
+        if ((int32_t)(tick - newestTick()) <= 0) return; // Late or duplicated, a newer one is in
+        const RaceState *base = &empty;
+        if (header.baseAge != 0) {
+            uint32_t baseTick = tick - header.baseAge;
+            base = &states[baseTick % RACE_HISTORY];
+            if (base->tick != baseTick) return; // The base is gone, the next snapshot will use a newer one
+        }
+        RaceState received;
+        if (!readSnapshotBody(in, *base, received)) return;
+        received.tick = tick;
+        states[tick % RACE_HISTORY] = received;
+        previous = latest.present ? latest : received;
+        latest = received;
+        snapshotBytes += size;
+        snapshotCount++;
+
+        for (int i = 0; i < RACE_MAX_PLAYERS; i++) {
+            bool ranked = false;
+            for (int j = 0; j < finishedCount; j++) ranked = ranked || finishOrder[j] == i;
+            if (!ranked && ((latest.finished >> i) & 1)) finishOrder[finishedCount++] = (uint8_t)i;
+        }
+        reconcile(extendCounter(header.ack, lastIntent));
+    }
+
+public:
+    RaceClient()
+        : server(), state(RaceClientState::Joining), welcome(), maze(nullptr), player(1, 1, 1), cellSize(1), lastIntent(0),
+          confirmedIntent(0), intents(), states(), previous(), latest(), empty(), finishOrder(), finishedCount(0),
+          resendCountdown(0), snapshotBytes(0), snapshotCount(0) {}
+
+    // Starts joining the race at address ("host:port" or "host"). Returns false if the
+    // address is unknown or no socket can be opened.
+    bool connect(const char *address) {
+        return resolveNetAddress(address, RACE_DEFAULT_PORT, server) && socket.open(0);
+    }
+
+    // Reads the server's packets and keeps the connection alive. Call it every frame.
+    void update() {
+        uint8_t packet[RACE_MAX_PACKET];
+        NetAddress from;
+        int size;
+        while ((size = socket.receive(packet, sizeof(packet), from)) >= 0) {
+            if (!(from == server)) continue;
+            RaceReader in(packet, (size_t)size);
+            RacePacket type = (RacePacket)in.u8();
+            if (type == RacePacket::Welcome && state == RaceClientState::Joining) {
+                if (!readWelcome(in, welcome) || welcome.algorithm >= (uint8_t)MAZE_ALGORITHM_COUNT) continue;
+                state = RaceClientState::Joined;
+            } else if (type == RacePacket::Full && state == RaceClientState::Joining) {
+                state = RaceClientState::Refused;
+            } else if (type == RacePacket::Snapshot && state != RaceClientState::Joining) {
+                receiveSnapshot(in, (size_t)size);
+            }
+        }
+
+        // Hellos until the welcome comes, then keepalives until the intents take over
+        if (state == RaceClientState::Racing || state == RaceClientState::Refused || --resendCountdown > 0) return;
+        resendCountdown = RACE_RESEND_TICKS;
+        if (state == RaceClientState::Joining) socket.send(server, packet, writeHello(packet));
+        else sendIntents(0);
+    }
+
+    // Starts racing on the maze generated from getWelcome(), which must outlive the race
+    void start(const Maze &raceMaze) {
+        maze = &raceMaze;
+        cellSize = raceMaze.getCellSize();
+        player = Player(1, 1, cellSize);
+        predicted.assign(RACE_INTENT_BUFFER, player);
+        state = RaceClientState::Racing;
+    }
+
+    // One local tick with the held direction: moves the predicted player and sends the intent
+    void tick(int dx, int dy) {
+        lastIntent++;
+        intents[lastIntent % RACE_INTENT_BUFFER] = raceIntent(dx, dy);
+        if (maze->isExit(player.getX(), player.getY())) dx = dy = 0;
+        player.tick(dx, dy, *maze);
+        predicted[lastIntent % RACE_INTENT_BUFFER] = player;
+        uint32_t unconfirmed = lastIntent - confirmedIntent;
+        sendIntents((int)std::min(unconfirmed, (uint32_t)RACE_INTENT_REDUNDANCY));
+    }
+
+    RaceClientState getState() const { return state; }
+    const RaceWelcome &getWelcome() const { return welcome; }
+    const Player &getPlayer() const { return player; }
+    int getSlot() const { return welcome.slot; }
+
+    // Position of another racer between the last two snapshots, alpha in [0, 1]. Returns
+    // false for the local player and for empty slots.
+    bool getOpponent(int slot, float alpha, Vector2 &position) const {
+        if (slot == welcome.slot || !((latest.present >> slot) & 1)) return false;
+        bool moved = (previous.present >> slot) & 1;
+        float fromX = moved ? previous.x[slot] : latest.x[slot], fromY = moved ? previous.y[slot] : latest.y[slot];
+        position = {fromX + (latest.x[slot] - fromX) * alpha, fromY + (latest.y[slot] - fromY) * alpha};
+        return true;
+    }
+
+    // Place of a racer at the exit (1 for the winner), 0 while it is still racing
+    int getPlace(int slot) const {
+        for (int i = 0; i < finishedCount; i++) {
+            if (finishOrder[i] == slot) return i + 1;
+        }
+        return 0;
+    }
+
+    int getRacerCount() const { return __builtin_popcount(latest.present); }
+
+    // Average snapshot size in bytes per racer, UDP and IP headers excluded
+    float getBytesPerRacer() const {
+        if (snapshotCount == 0 || latest.present == 0) return 0.0f;
+        return (float)snapshotBytes / snapshotCount / getRacerCount();
+    }
+};
+
+#endif // RACE_SESSION_H
@@ -0,0 +1,151 @@
+// UDP sockets of the race mode.
+// Kept out of the headers for the same reason as maze_file.cpp: winsock2.h pulls in
+// windows.h, which cannot be included next to raylib.h. This file therefore never
+// includes raylib.h.
+
+#include "race_socket.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(_WIN32)
+int openSockets = 0;                     // Sockets open, Winsock is started with the first one
+
+bool startSockets() {
+    WSADATA data;
+    if (openSockets == 0 && WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+    openSockets++;
+    return true;
+}
+
+void stopSockets() {
+    if (--openSockets == 0) WSACleanup();
+}
+#endif
+
+sockaddr_in toSockaddr(const NetAddress &address) {
+    sockaddr_in result;
+    memset(&result, 0, sizeof(result));
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = htonl(address.host);
+    result.sin_port = htons(address.port);
+    return result;
+}
+
+} // namespace
+
+bool resolveNetAddress(const char *text, uint16_t defaultPort, NetAddress &address) {
+    std::string host = text;
+    long port = defaultPort;
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        char *end;
+        port = strtol(host.c_str() + colon + 1, &end, 10);
+        if (*end != '\0' || port <= 0 || port > 65535) return false;
+        host.resize(colon);
+    }
+
+#if defined(_WIN32)
+    if (!startSockets()) return false;
+#endif
+    addrinfo hints, *found = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    bool ok = getaddrinfo(host.c_str(), nullptr, &hints, &found) == 0 && found;
+    if (ok) {
+        address.host = ntohl(((const sockaddr_in *)found->ai_addr)->sin_addr.s_addr);
+        address.port = (uint16_t)port;
+    }
+    if (found) freeaddrinfo(found);
+#if defined(_WIN32)
+    stopSockets();
+#endif
+    return ok;
+}
+
+bool UdpSocket::open(uint16_t port) {
+    close();
+#if defined(PLATFORM_WEB)
+    (void)port;
+    return false; // A page can only talk to its server over WebSockets or WebRTC
+#else
+#if defined(_WIN32)
+    if (!startSockets()) return false;
+    SOCKET fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd == INVALID_SOCKET) {
+        stopSockets();
+        return false;
+    }
+    u_long nonBlocking = 1;
+    BOOL reportResets = FALSE; // Or a peer that went away fails every later receive
+    DWORD returned;
+    WSAIoctl(fd, _WSAIOW(IOC_VENDOR, 12), &reportResets, sizeof(reportResets), nullptr, 0, &returned, nullptr,
+             nullptr); // SIO_UDP_CONNRESET
+    bool ok = ioctlsocket(fd, FIONBIO, &nonBlocking) == 0;
+#else
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) return false;
+    bool ok = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    sockaddr_in local = toSockaddr({INADDR_ANY, port});
+    ok = ok && bind(fd, (const sockaddr *)&local, sizeof(local)) == 0;
+    handle = (intptr_t)fd;
+    if (!ok) close();
+    return ok;
+#endif
+}
+
+void UdpSocket::close() {
+    if (handle == -1) return;
+#if defined(_WIN32)
+    closesocket((SOCKET)handle);
+    stopSockets();
+#else
+    ::close((int)handle);
+#endif
+    handle = -1;
+}
+
+bool UdpSocket::send(const NetAddress &to, const void *data, size_t size) {
+    if (handle == -1) return false;
+    sockaddr_in address = toSockaddr(to);
+#if defined(_WIN32)
+    return sendto((SOCKET)handle, (const char *)data, (int)size, 0, (const sockaddr *)&address, sizeof(address)) ==
+           (int)size;
+#else
+    return sendto((int)handle, data, size, 0, (const sockaddr *)&address, sizeof(address)) == (ssize_t)size;
+#endif
+}
+
+int UdpSocket::receive(void *data, size_t capacity, NetAddress &from) {
+    if (handle == -1) return -1;
+    sockaddr_in address;
+#if defined(_WIN32)
+    int length = sizeof(address);
+    int size = recvfrom((SOCKET)handle, (char *)data, (int)capacity, 0, (sockaddr *)&address, &length);
+#else
+    socklen_t length = sizeof(address);
+    int size = (int)recvfrom((int)handle, data, capacity, 0, (sockaddr *)&address, &length);
+#endif
+    if (size < 0) return -1; // Nothing waiting, or a datagram larger than capacity
+    from.host = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+    return size;
+}
@@ -0,0 +1,46 @@
+#ifndef RACE_SOCKET_H
+#define RACE_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// IPv4 address and port of a peer, both in host byte order
+struct NetAddress {
+    uint32_t host;
+    uint16_t port;
+
+    bool operator==(const NetAddress &other) const { return host == other.host && port == other.port; }
+};
+
+// Resolves "host:port", or "host" alone with defaultPort. Returns false if the host is unknown.
+bool resolveNetAddress(const char *text, uint16_t defaultPort, NetAddress &address);
+
+// UdpSocket class definition
+// Non-blocking IPv4 UDP socket. The platform socket headers stay in race_socket.cpp:
+// winsock2.h, like windows.h, cannot be included next to raylib.h. Browsers have no
+// UDP, so on the web open() always fails.
+class UdpSocket {
+private:
+    intptr_t handle;                     // Platform socket, -1 when closed
+
+public:
+    UdpSocket() : handle(-1) {}
+    ~UdpSocket() { close(); }
+
+    // The socket is owned by a single object
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator=(const UdpSocket &) = delete;
+
+    // Opens the socket on a local port, 0 for any. Returns false if the port is taken.
+    bool open(uint16_t port);
+    void close();
+    bool isOpen() const { return handle != -1; }
+
+    // Sends one datagram. Returns false if it could not be queued.
+    bool send(const NetAddress &to, const void *data, size_t size);
+
+    // Reads one waiting datagram into data. Returns its size, or -1 when none is waiting.
+    int receive(void *data, size_t capacity, NetAddress &from);
+};
+
+#endif // RACE_SOCKET_H
@@ -0,0 +1,230 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "maze.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// On-disk replay format, all fields little-endian:
+//   ReplayFileHeader  40 bytes
+//   moves             moveCount unsigned LEB128 varints, one per accepted move:
+//                     (ticks since the previous move << 2) | direction
+// The maze is not stored: it is generated again from its seed and dimensions.
+// A move every 12 ticks takes one byte, so a minute of play is under 300 bytes.
+const uint32_t REPLAY_FILE_MAGIC = 0x50525A4D; // "MZRP"
+const uint16_t REPLAY_FILE_VERSION = 1;
+
+struct ReplayFileHeader {
+    uint32_t magic;                      // REPLAY_FILE_MAGIC
+    uint16_t version;                    // REPLAY_FILE_VERSION
+    uint16_t reserved;                   // Zero
+    uint64_t seed;                       // Seed of the maze
+    int32_t width, height;               // Dimensions of the maze in cells
+    uint32_t algorithm;                  // MazeAlgorithm the maze was carved with
+    int32_t cellSize;                    // Cell size it was played at, only used to show the replay
+    uint32_t moveCount;                  // Number of moves in the stream
+    uint32_t payloadSize;                // Bytes of move stream after the header
+};
+
+static_assert(sizeof(ReplayFileHeader) == 40, "The replay file header must stay 40 bytes");
+
+// Direction of a move, in the low 2 bits of each encoded move
+enum class ReplayDirection : uint8_t { Up, Down, Left, Right };
+
+// One accepted move
+struct ReplayMove {
+    uint32_t tick;                       // Simulation tick the move happened on, 0 being the level start
+    ReplayDirection direction;
+};
+
+// Cell offset of a direction
+inline void replayStep(ReplayDirection direction, int &dx, int &dy) {
+    static const int stepX[4] = {0, 0, -1, 1};
+    static const int stepY[4] = {-1, 1, 0, 0};
+    dx = stepX[(int)direction];
+    dy = stepY[(int)direction];
+}
+
+// Replay class definition
+// The moves the player made in one level, recorded as they are accepted and kept
+// encoded. Decoding walks the stream with a ReplayCursor.
+class Replay {
+private:
+    ReplayFileHeader header;             // Maze and move count, as written to the file
+    std::vector<uint8_t> moves;          // Encoded move stream
+    uint32_t lastTick;                   // Tick of the last recorded move
+
+public:
+    Replay() : header(), lastTick(0) {}
+
+    // Starts recording a level, dropping the previous one
+    void begin(const Maze &maze) {
+        header = ReplayFileHeader();
+        header.magic = REPLAY_FILE_MAGIC;
+        header.version = REPLAY_FILE_VERSION;
+        header.seed = maze.getSeed();
+        header.width = maze.getWidth();
+        header.height = maze.getHeight();
+        header.algorithm = (uint32_t)maze.getAlgorithm();
+        header.cellSize = maze.getCellSize();
+        moves.clear();
+        lastTick = 0;
+    }
+
+    // Appends a move of (dx, dy) made on the given tick. Ticks must not decrease.
+    void record(uint32_t tick, int dx, int dy) {
+        ReplayDirection direction = dy < 0 ? ReplayDirection::Up : dy > 0 ? ReplayDirection::Down :
+                                    dx < 0 ? ReplayDirection::Left : ReplayDirection::Right;
+        uint64_t value = ((uint64_t)(tick - lastTick) << 2) | (uint8_t)direction;
+        do {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            moves.push_back(value ? (uint8_t)(byte | 0x80) : byte);
+        } while (value);
+        lastTick = tick;
+        header.moveCount++;
+    }
+
+    // Writes the replay. Returns false on I/O errors.
+    bool save(const char *path) const {
+        FILE *file = fopen(path, "wb");
+        if (!file) return false;
+        ReplayFileHeader written = header;
+        written.payloadSize = (uint32_t)moves.size();
+        bool ok = fwrite(&written, sizeof(written), 1, file) == 1 &&
+                  (moves.empty() || fwrite(moves.data(), 1, moves.size(), file) == moves.size());
+        return fclose(file) == 0 && ok;
+    }
+
+    // Reads a replay. Returns false if the file is missing, truncated or not a replay.
+    bool load(const char *path) {
+        FILE *file = fopen(path, "rb");
+        if (!file) return false;
+        ReplayFileHeader read;
+        bool ok = fread(&read, sizeof(read), 1, file) == 1 && read.magic == REPLAY_FILE_MAGIC &&
+                  read.version == REPLAY_FILE_VERSION && read.width > 0 && read.height > 0 &&
+                  read.width <= MAX_GENERATED_MAZE_SIDE && read.height <= MAX_GENERATED_MAZE_SIDE &&
+                  read.algorithm < (uint32_t)MAZE_ALGORITHM_COUNT && read.moveCount <= read.payloadSize;
+        if (ok) {
+            // The stream must be in the file before it is allocated: a move takes at least a byte
+            long payloadStart = ftell(file);
+            ok = payloadStart >= 0 && fseek(file, 0, SEEK_END) == 0;
+            long fileEnd = ok ? ftell(file) : -1;
+            ok = ok && fileEnd >= payloadStart && (uint64_t)(fileEnd - payloadStart) >= read.payloadSize &&
+                 fseek(file, payloadStart, SEEK_SET) == 0;
+        }
+        std::vector<uint8_t> stream;
+        if (ok) {
+            stream.resize(read.payloadSize);
+            ok = stream.empty() || fread(stream.data(), 1, stream.size(), file) == stream.size();
+        }
+        fclose(file);
+        if (!ok) return false;
+        header = read;
+        moves.swap(stream);
+        lastTick = 0;
+        return true;
+    }
+
+    const ReplayFileHeader &getHeader() const { return header; }
+    const std::vector<uint8_t> &getStream() const { return moves; }
+};
+
+// ReplayCursor class definition
+// Decodes the moves of a replay one at a time, in order
+class ReplayCursor {
+private:
+    const uint8_t *position, *end;       // Rest of the encoded stream
+    uint32_t movesLeft;                  // Moves not decoded yet
+    uint32_t tick;                       // Tick of the last decoded move
+    bool corrupt;                        // Set when the stream ends in the middle of a move
+
+public:
+    explicit ReplayCursor(const Replay &replay)
+        : position(replay.getStream().data()), end(replay.getStream().data() + replay.getStream().size()),
+          movesLeft(replay.getHeader().moveCount), tick(0), corrupt(false) {}
+
+    // Decodes the next move. Returns false after the last one or on a corrupt stream.
+    bool next(ReplayMove &move) {
+        if (movesLeft == 0) return false;
+        uint64_t value = 0;
+        int shift = 0;
+        while (true) {
+            if (position == end || shift > 35) { // Ran past the stream, or longer than any 32-bit tick delta
+                corrupt = true;
+                movesLeft = 0;
+                return false;
+            }
+            uint8_t byte = *position++;
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) break;
+        }
+        tick += (uint32_t)(value >> 2);
+        move = {tick, (ReplayDirection)(value & 3)};
+        movesLeft--;
+        return true;
+    }
+
+    // Whether the stream was cut short, or has bytes left after the last move
+    bool isCorrupt() const { return corrupt || (movesLeft == 0 && position != end); }
+};
+
+// Outcome of checking a replay against its maze
+enum class ReplayVerdict {
+    Valid,                               // Every move was legal and the last one reached the exit
+    WrongMaze,                           // The maze does not have the replay's seed or dimensions
+    Corrupt,                             // The move stream cannot be decoded
+    TooFast,                             // Two moves closer than the move cooldown allows
+    IntoWall,                            // A move into a wall or out of the maze
+    PastExit,                            // Moves left after the exit was reached
+    NotFinished                          // The moves end before the exit
+};
+
+// Result of validateReplay
+struct ReplayCheck {
+    ReplayVerdict verdict;
+    uint32_t moves;                      // Moves checked, up to and including the failing one
+    uint32_t ticks;                      // Tick of the last checked move, the run time of a valid replay
+};
+
+// Checks a run move by move against the game's rules: start on (startX, startY), at
+// least moveCooldown ticks between two moves, never into a wall, and stop on the exit.
+// Idle ticks cost nothing, so a run takes microseconds to check however long it lasted.
+inline ReplayCheck validateReplay(const Replay &replay, const Maze &maze, int startX, int startY, int moveCooldown) {
+    const ReplayFileHeader &header = replay.getHeader();
+    if (header.seed != maze.getSeed() || header.width != maze.getWidth() || header.height != maze.getHeight() ||
+        header.algorithm != (uint32_t)maze.getAlgorithm()) {
+        return {ReplayVerdict::WrongMaze, 0, 0};
+    }
+
+    ReplayCursor cursor(replay);
+    ReplayMove move;
+    int x = startX, y = startY;
+    uint32_t checked = 0, previousTick = 0;
+    while (cursor.next(move)) {
+        if (maze.isExit(x, y)) return {ReplayVerdict::PastExit, checked, previousTick};
+        checked++;
+        if (checked > 1 && move.tick - previousTick < (uint32_t)moveCooldown) {
+            return {ReplayVerdict::TooFast, checked, move.tick};
+        }
+        int dx, dy;
+        replayStep(move.direction, dx, dy);
+        x += dx;
+        y += dy;
+        if (maze.isWall(x, y)) return {ReplayVerdict::IntoWall, checked, move.tick};
+        previousTick = move.tick;
+    }
+    if (cursor.isCorrupt()) return {ReplayVerdict::Corrupt, checked, previousTick};
+    if (!maze.isExit(x, y)) return {ReplayVerdict::NotFinished, checked, previousTick};
+    return {ReplayVerdict::Valid, checked, previousTick};
+}
+
+inline const char *replayVerdictName(ReplayVerdict verdict) {
+    static const char *names[] = {"valid", "wrong maze", "corrupt", "too fast", "into a wall", "moves past the exit",
+                                  "does not reach the exit"};
+    return names[(int)verdict];
+}
+
+#endif // REPLAY_H
@@ -0,0 +1,78 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+// Rng class definition
+// Small, fast and reproducible random generator (xoshiro256**), seeded through
+// SplitMix64 so that any 64-bit seed, including 0, gives a well mixed state.
+// Each generation owns its own Rng: no global state, safe to use on any thread.
+class Rng {
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    explicit Rng(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            state[i] = z ^ (z >> 31);
+        }
+    }
+
+    // Next 64 random bits
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, n), n > 0 (Lemire's multiply-shift with rejection)
+    uint32_t below(uint32_t n) {
+        uint64_t m = (next() >> 32) * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t threshold = (uint32_t)(-n) % n;
+            while (low < threshold) {
+                m = (next() >> 32) * n;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // Fair coin flip
+    bool chance() {
+        return next() >> 63;
+    }
+};
+
+// SplitMix64 finalizer: turns related inputs (counters, coordinates) into unrelated seeds
+inline uint64_t mixSeed(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Fresh seed for a new level, from the OS entropy source mixed with the clock
+inline uint64_t makeRandomSeed() {
+    std::random_device device;
+    uint64_t seed = ((uint64_t)device() << 32) ^ device();
+    return seed ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+#endif // RNG_H
@@ -0,0 +1,206 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include "raylib.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Part of a texture drawn as one sprite
+struct SpriteFrame {
+    Texture2D texture;                   // Texture holding the sprite (usually the atlas)
+    Rectangle source;                    // Pixels of the sprite inside the texture
+};
+
+// Frame covering a whole texture
+inline SpriteFrame wholeTexture(Texture2D texture) {
+    return {texture, {0, 0, (float)texture.width, (float)texture.height}};
+}
+
+// Draws a sprite stretched over dest
+inline void drawSprite(const SpriteFrame &sprite, Rectangle dest, Color tint) {
+    if (sprite.source.width <= 0 || sprite.source.height <= 0) return;
+    DrawTexturePro(sprite.texture, sprite.source, dest, {0, 0}, 0.0f, tint);
+}
+
+// Draws a sprite scaled to the given width, keeping its aspect ratio (like DrawTextureEx)
+inline void drawSpriteScaled(const SpriteFrame &sprite, Vector2 position, float width, Color tint) {
+    if (sprite.source.width <= 0) return;
+    drawSprite(sprite, {position.x, position.y, width, sprite.source.height * width / sprite.source.width}, tint);
+}
+
+// Image file packed into the atlas
+struct SpriteSource {
+    const char *path;                    // PNG to load
+    int maxSide;                         // Downscale so neither side exceeds this, 0 keeps the full size
+};
+
+// SpriteAtlas class definition
+// Every sprite of the game in one texture: the player and exit sprites all sample
+// the same texture, so raylib's batcher draws them without switching textures.
+// The images are decoded in parallel, then packed on shelves (tallest first) and
+// uploaded once. Decoding can also stream in behind the first frames: a loader
+// thread decodes while the game runs, and poll() packs and uploads on the GL thread.
+class SpriteAtlas {
+private:
+    static const int PADDING = 2;        // Empty pixels between sprites so filtering never bleeds
+    static const int ATLAS_WIDTH = 2048; // Width of the atlas, any sprite wider than this widens it
+
+    Texture2D texture;                   // Atlas texture, id 0 until loaded
+    std::vector<Rectangle> regions;      // Where each sprite ended up, in the order of the sources
+    std::thread loader;                  // Decodes the sources of loadAsync()
+    std::vector<Image> decodedImages;    // Written by the loader, packed by poll()
+    std::atomic<bool> decoded;           // Set by the loader once decodedImages is complete
+    std::chrono::steady_clock::time_point loadStart; // When the current load began
+    float decodeMs;                      // Time the decoding of the current load took
+
+    // Decodes the sources on one thread each. Decoding and resizing only touch CPU
+    // memory, so they can run off the GL thread.
+    std::vector<Image> decode(const SpriteSource *sources, int count) {
+        std::vector<Image> images(count);
+        std::vector<std::thread> decoders;
+        for (int i = 0; i < count; i++) {
+            decoders.emplace_back([&images, sources, i] {
+                Image image = LoadImage(sources[i].path);
+                if (image.data) {
+                    int side = std::max(image.width, image.height), maxSide = sources[i].maxSide;
+                    if (maxSide > 0 && side > maxSide) {
+                        ImageResize(&image, std::max(1, image.width * maxSide / side), std::max(1, image.height * maxSide / side));
+                    }
+                    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+                }
+                images[i] = image;
+            });
+        }
+        for (std::thread &decoder : decoders) decoder.join();
+        decodeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        return images;
+    }
+
+    // Packs decoded images into the atlas and uploads it, freeing the images. Needs a window.
+    void pack(std::vector<Image> &images) {
+        int count = (int)images.size();
+
+        // Shelf packing, tallest sprites first
+        std::vector<int> order(count);
+        int atlasWidth = ATLAS_WIDTH;
+        for (int i = 0; i < count; i++) {
+            order[i] = i;
+            if (images[i].data) atlasWidth = std::max(atlasWidth, images[i].width + 2 * PADDING);
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return images[a].height > images[b].height; });
+
+        regions.assign(count, Rectangle{0, 0, 0, 0});
+        int shelfX = PADDING, shelfY = PADDING, shelfHeight = 0;
+        for (int i : order) {
+            if (!images[i].data) continue;
+            if (shelfX + images[i].width + PADDING > atlasWidth) { // Start a new shelf
+                shelfY += shelfHeight + PADDING;
+                shelfX = PADDING;
+                shelfHeight = 0;
+            }
+            regions[i] = {(float)shelfX, (float)shelfY, (float)images[i].width, (float)images[i].height};
+            shelfX += images[i].width + PADDING;
+            shelfHeight = std::max(shelfHeight, images[i].height);
+        }
+        int atlasHeight = shelfY + shelfHeight + PADDING;
+
+        // Copy the rows into the atlas image, images are all RGBA8 by now
+        Image atlas = GenImageColor(atlasWidth, atlasHeight, BLANK);
+        for (int i = 0; i < count; i++) {
+            if (!images[i].data) continue;
+            const unsigned char *pixels = (const unsigned char *)images[i].data;
+            unsigned char *target = (unsigned char *)atlas.data;
+            for (int y = 0; y < images[i].height; y++) {
+                memcpy(target + (((size_t)regions[i].y + y) * atlasWidth + (size_t)regions[i].x) * 4,
+                       pixels + (size_t)y * images[i].width * 4, (size_t)images[i].width * 4);
+            }
+            UnloadImage(images[i]);
+        }
+
+        texture = LoadTextureFromImage(atlas);
+        UnloadImage(atlas);
+        images.clear();
+        TraceLog(LOG_INFO, "ATLAS: %d sprites packed into %dx%d (decode %.1f ms, total %.1f ms)", count,
+                 atlasWidth, atlasHeight, decodeMs,
+                 std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count());
+    }
+
+public:
+    SpriteAtlas() : texture(), decoded(false), decodeMs(0) {}
+
+    ~SpriteAtlas() { unload(); }
+
+    SpriteAtlas(const SpriteAtlas &) = delete;
+    SpriteAtlas &operator=(const SpriteAtlas &) = delete;
+
+    // Decodes the sources on one thread each, packs and uploads them. Needs a window.
+    // A source that fails to load gets an empty region and draws nothing.
+    void load(const SpriteSource *sources, int count) {
+        unload();
+        loadStart = std::chrono::steady_clock::now();
+        std::vector<Image> images = decode(sources, count);
+        pack(images);
+    }
+
+    // Starts decoding the sources on a loader thread and returns at once. Until poll()
+    // has uploaded them every sprite is empty and draws nothing. The sources must stay
+    // valid until then.
+    void loadAsync(const SpriteSource *sources, int count) {
+        unload();
+        loadStart = std::chrono::steady_clock::now();
+        decoded.store(false, std::memory_order_relaxed);
+        loader = std::thread([this, sources, count] {
+            decodedImages = decode(sources, count);
+            decoded.store(true, std::memory_order_release);
+        });
+    }
+
+    // Uploads the sprites of loadAsync() once they are decoded; call it every frame from the
+    // GL thread. Returns true on the call that made them available.
+    bool poll() {
+        if (!loader.joinable() || !decoded.load(std::memory_order_acquire)) return false;
+        loader.join();
+        pack(decodedImages);
+        return true;
+    }
+
+    // Whether the sprites are uploaded and can be drawn
+    bool isLoaded() const { return texture.id != 0; }
+
+    // Releases the atlas texture, waiting for an unfinished loadAsync() first
+    void unload() {
+        if (loader.joinable()) {
+            loader.join();
+            for (Image &image : decodedImages) {
+                if (image.data) UnloadImage(image);
+            }
+            decodedImages.clear();
+        }
+        if (texture.id != 0) UnloadTexture(texture);
+        texture = Texture2D();
+        regions.clear();
+    }
+
+    // Whole sprite i, in the order of the sources given to load(); empty until loaded
+    SpriteFrame frame(int i) const {
+        if ((size_t)i >= regions.size()) return {texture, {0, 0, 0, 0}};
+        return {texture, regions[i]};
+    }
+
+    // Part of sprite i, in pixels of the original sprite, clipped to the sprite
+    SpriteFrame frame(int i, Rectangle crop) const {
+        if ((size_t)i >= regions.size()) return {texture, {0, 0, 0, 0}};
+        Rectangle region = regions[i];
+        float x = std::min(crop.x, region.width), y = std::min(crop.y, region.height);
+        return {texture, {region.x + x, region.y + y, std::min(crop.width, region.width - x),
+                          std::min(crop.height, region.height - y)}};
+    }
+
+    Texture2D getTexture() const { return texture; }
+};
+
+#endif // SPRITE_ATLAS_H
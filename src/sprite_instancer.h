@@ -0,0 +1,162 @@
+#ifndef SPRITE_INSTANCER_H
+#define SPRITE_INSTANCER_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "sprite_atlas.h"
+#include <algorithm>
+#include <string>
+
+// Unit quad the instances are stretched from, two triangles
+const float INSTANCE_QUAD[12] = {0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0};
+
+// Places one copy of the quad per instance, sized and textured by uniforms
+const char *const INSTANCE_VERTEX_SHADER = R"(
+in vec2 vertexPosition;
+in vec2 instancePosition;
+uniform mat4 mvp;
+uniform vec2 spriteSize;
+uniform vec4 sourceRect;
+out vec2 fragTexCoord;
+void main() {
+    fragTexCoord = sourceRect.xy + vertexPosition * sourceRect.zw;
+    gl_Position = mvp * vec4(instancePosition + vertexPosition * spriteSize, 0.0, 1.0);
+}
+)";
+
+const char *const INSTANCE_FRAGMENT_SHADER = R"(
+in vec2 fragTexCoord;
+uniform sampler2D texture0;
+uniform vec4 tint;
+out vec4 finalColor;
+void main() {
+    finalColor = texture(texture0, fragTexCoord) * tint;
+}
+)";
+
+// SpriteInstancer class definition
+// Draws many copies of one sprite in a single draw call: a unit quad is shared by
+// every copy and the positions go to a per-instance vertex buffer, re-uploaded
+// at each draw. Needs OpenGL 3.3 or OpenGL ES 3.0; on older contexts the copies
+// go through raylib's batch instead, which still groups them by texture.
+class SpriteInstancer {
+private:
+    Shader shader;                       // Instancing shader, id 0 until loaded
+    int mvpLoc, sizeLoc, sourceLoc, tintLoc, textureLoc; // Uniform locations
+    unsigned int vertexArray;            // Quad and instance attributes
+    unsigned int quadBuffer;             // The unit quad
+    unsigned int instanceBuffer;         // One position per instance
+    int instanceLoc;                     // Attribute location of the instance position
+    size_t capacity;                     // Positions instanceBuffer can hold
+    bool instanced;                      // Whether the GPU path is in use
+
+    // Replaces the instance buffer with one holding at least count positions
+    void reserve(size_t count) {
+        if (count <= capacity) return;
+        capacity = std::max(count, std::max<size_t>(1024, capacity * 2));
+        rlEnableVertexArray(vertexArray);
+        if (instanceBuffer) rlUnloadVertexBuffer(instanceBuffer);
+        instanceBuffer = rlLoadVertexBuffer(nullptr, (int)(capacity * sizeof(Vector2)), true);
+        rlSetVertexAttribute(instanceLoc, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(instanceLoc);
+        rlSetVertexAttributeDivisor(instanceLoc, 1);
+        rlDisableVertexArray();
+    }
+
+public:
+    SpriteInstancer()
+        : shader(), mvpLoc(-1), sizeLoc(-1), sourceLoc(-1), tintLoc(-1), textureLoc(-1), vertexArray(0), quadBuffer(0),
+          instanceBuffer(0), instanceLoc(-1), capacity(0), instanced(false) {}
+
+    ~SpriteInstancer() { unload(); }
+
+    SpriteInstancer(const SpriteInstancer &) = delete;
+    SpriteInstancer &operator=(const SpriteInstancer &) = delete;
+
+    // Compiles the shader and builds the quad. Needs a window. Falls back to the batch when instancing is missing.
+    void load() {
+        unload();
+        int version = rlGetVersion();
+        if (version != RL_OPENGL_33 && version != RL_OPENGL_43 && version != RL_OPENGL_ES_30) {
+            TraceLog(LOG_INFO, "INSTANCER: No instancing on this context, sprites go through the batch");
+            return;
+        }
+        std::string header = (version == RL_OPENGL_ES_30) ? "#version 300 es\nprecision mediump float;\n" : "#version 330\n";
+        shader = LoadShaderFromMemory((header + INSTANCE_VERTEX_SHADER).c_str(), (header + INSTANCE_FRAGMENT_SHADER).c_str());
+        if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) { // raylib hands out its default shader on failure
+            TraceLog(LOG_WARNING, "INSTANCER: Shader failed to compile, sprites go through the batch");
+            shader = Shader();
+            return;
+        }
+        mvpLoc = GetShaderLocation(shader, "mvp");
+        sizeLoc = GetShaderLocation(shader, "spriteSize");
+        sourceLoc = GetShaderLocation(shader, "sourceRect");
+        tintLoc = GetShaderLocation(shader, "tint");
+        textureLoc = GetShaderLocation(shader, "texture0");
+        instanceLoc = GetShaderLocationAttrib(shader, "instancePosition");
+
+        // vertexPosition is bound to raylib's default position slot
+        vertexArray = rlLoadVertexArray();
+        rlEnableVertexArray(vertexArray);
+        quadBuffer = rlLoadVertexBuffer(INSTANCE_QUAD, sizeof(INSTANCE_QUAD), false);
+        rlSetVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION);
+        rlDisableVertexArray();
+        reserve(1024);
+        instanced = true;
+    }
+
+    // Releases the GPU resources
+    void unload() {
+        if (instanceBuffer) rlUnloadVertexBuffer(instanceBuffer);
+        if (quadBuffer) rlUnloadVertexBuffer(quadBuffer);
+        if (vertexArray) rlUnloadVertexArray(vertexArray);
+        if (shader.id != 0) UnloadShader(shader);
+        shader = Shader();
+        vertexArray = quadBuffer = instanceBuffer = 0;
+        capacity = 0;
+        instanced = false;
+    }
+
+    // Draws the sprite at each position (top-left corners, in the current 2D camera's space), all the same size
+    void draw(const SpriteFrame &sprite, const Vector2 *positions, size_t count, Vector2 size, Color tint) {
+        if (count == 0 || sprite.source.width <= 0 || sprite.source.height <= 0) return;
+        if (!instanced) {
+            for (size_t i = 0; i < count; i++) drawSprite(sprite, {positions[i].x, positions[i].y, size.x, size.y}, tint);
+            return;
+        }
+
+        rlDrawRenderBatchActive(); // What was queued so far lands underneath
+        reserve(count);
+        rlUpdateVertexBuffer(instanceBuffer, positions, (int)(count * sizeof(Vector2)), 0);
+
+        float texWidth = (float)sprite.texture.width, texHeight = (float)sprite.texture.height;
+        float spriteSize[2] = {size.x, size.y};
+        float source[4] = {sprite.source.x / texWidth, sprite.source.y / texHeight, sprite.source.width / texWidth,
+                           sprite.source.height / texHeight};
+        float color[4] = {tint.r / 255.0f, tint.g / 255.0f, tint.b / 255.0f, tint.a / 255.0f};
+        int textureSlot = 0;
+
+        rlEnableShader(shader.id);
+        rlSetUniformMatrix(mvpLoc, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+        rlSetUniform(sizeLoc, spriteSize, RL_SHADER_UNIFORM_VEC2, 1);
+        rlSetUniform(sourceLoc, source, RL_SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(tintLoc, color, RL_SHADER_UNIFORM_VEC4, 1);
+        rlSetUniform(textureLoc, &textureSlot, RL_SHADER_UNIFORM_INT, 1);
+        rlActiveTextureSlot(0);
+        rlEnableTexture(sprite.texture.id);
+
+        rlEnableVertexArray(vertexArray);
+        rlDrawVertexArrayInstanced(0, 6, (int)count);
+        rlDisableVertexArray();
+
+        rlDisableTexture();
+        rlDisableShader();
+    }
+
+    // Whether draws go to the GPU in one call rather than through the batch
+    bool isInstanced() const { return instanced; }
+};
+
+#endif // SPRITE_INSTANCER_H
@@ -0,0 +1,47 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+// SpscRing class definition
+// Fixed-capacity queue between exactly one producer thread and one consumer thread.
+// Lock-free: each side only writes its own index, and the acquire/release pairs on
+// the indices publish the items. Capacity must be a power of two; one slot stays
+// empty to tell a full ring from an empty one.
+template <typename T, size_t Capacity>
+class SpscRing {
+private:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    T items[Capacity];
+    std::atomic<size_t> head;            // Next slot to read, written by the consumer only
+    std::atomic<size_t> tail;            // Next slot to write, written by the producer only
+
+public:
+    SpscRing() : items(), head(0), tail(0) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side. Returns false, dropping nothing, when the ring is full.
+    bool push(const T &item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        size_t next = (position + 1) & (Capacity - 1);
+        if (next == head.load(std::memory_order_acquire)) return false;
+        items[position] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the ring is empty.
+    bool pop(T &item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) return false;
+        item = items[position];
+        head.store((position + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,145 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool class definition
+// Fixed set of worker threads, one task deque each. A worker runs its own tasks
+// newest first and, when it runs dry, steals the oldest task of another worker,
+// so long and short tasks (a giant maze next to an easy one) keep every core busy.
+// Workers only take the shared lock to sleep when there is nothing left anywhere.
+class ThreadPool {
+private:
+    // Task deque of one worker
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues; // One deque per worker
+    std::vector<std::thread> workers;    // Worker threads, worker i owns queues[i]
+    std::atomic<int> queuedTasks;        // Tasks waiting in any deque
+    std::atomic<unsigned> nextQueue;     // Round-robin target of tasks submitted from outside the pool
+    std::mutex sleepMutex;               // Paired with wake, held when stopping is set
+    std::condition_variable wake;        // Wakes sleeping workers when a task arrives
+    std::atomic<bool> stopping;          // Set by shutdown(), checked before every task
+
+    // Index of the calling thread in this pool, -1 for any other thread
+    int currentWorker() const {
+        for (size_t i = 0; i < workers.size(); i++) {
+            if (workers[i].get_id() == std::this_thread::get_id()) return (int)i;
+        }
+        return -1;
+    }
+
+    // Takes the newest task of worker i, or steals the oldest task of another worker
+    bool findTask(int index, std::function<void()> &task) {
+        int count = (int)queues.size();
+        for (int k = 0; k < count; k++) {
+            WorkerQueue &queue = *queues[(index + k) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            if (k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            queuedTasks--;
+            return true;
+        }
+        return false;
+    }
+
+    // Worker loop: run tasks while there are any, sleep otherwise, return once stopping
+    void run(int index) {
+        std::function<void()> task;
+        while (!stopping.load()) {
+            if (findTask(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [&] { return stopping.load() || queuedTasks.load() > 0; });
+        }
+    }
+
+public:
+    // Starts one worker per hardware thread unless told otherwise
+    explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency())
+        : queuedTasks(0), nextQueue(0), stopping(false) {
+        threadCount = std::max(1u, threadCount);
+        for (unsigned i = 0; i < threadCount; i++) queues.emplace_back(new WorkerQueue());
+        for (unsigned i = 0; i < threadCount; i++) workers.emplace_back(&ThreadPool::run, this, (int)i);
+    }
+
+    ~ThreadPool() { shutdown(); }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Queues a task. Tasks submitted by a worker go to its own deque, the others are spread round-robin.
+    void submit(std::function<void()> task) {
+        int index = currentWorker();
+        if (index < 0) index = (int)(nextQueue++ % queues.size());
+        {
+            WorkerQueue &queue = *queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+            queuedTasks++;
+        }
+        std::lock_guard<std::mutex> lock(sleepMutex); // A worker deciding to sleep sees the task or the notify
+        wake.notify_one();
+    }
+
+    // Stops the workers once their current task is done. Queued tasks are dropped unrun.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers) worker.join();
+        for (std::unique_ptr<WorkerQueue> &queue : queues) queue->tasks.clear();
+        queuedTasks = 0;
+    }
+
+    // Splits [0, count) into one range per worker, runs body(begin, end) on each and waits
+    // for all of them. Must be called from outside the pool.
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)> &body) {
+        size_t chunks = std::min(count, workers.size());
+        if (chunks <= 1) {
+            if (count > 0) body(0, count);
+            return;
+        }
+
+        std::mutex doneMutex;
+        std::condition_variable done;
+        size_t remaining = chunks;
+        for (size_t c = 0; c < chunks; c++) {
+            size_t begin = count * c / chunks, end = count * (c + 1) / chunks;
+            submit([&, begin, end] {
+                body(begin, end);
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (--remaining == 0) done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&] { return remaining == 0; });
+    }
+
+    size_t getThreadCount() const { return workers.size(); }
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,132 @@
+#ifndef WALL_GRID_H
+#define WALL_GRID_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// WallGrid class definition
+// Bit-packed wall plane stored in one contiguous buffer: one bit per cell, 1 = wall.
+// Each row is padded to a whole number of 64-bit words, and the padding bits are walls too.
+// The buffer is either owned by the grid or external memory, e.g. a memory-mapped maze file.
+class WallGrid {
+private:
+    int width, height;             // Dimensions of the grid in cells
+    int stride;                    // Number of 64-bit words per row
+    std::vector<uint64_t> words;   // Row-major wall bits, when the grid owns them
+    uint64_t *bits;                // Start of the wall bits, owned or external
+    std::shared_ptr<void> backing; // Keeps external memory alive as long as the grid uses it
+
+public:
+    // Constructor to initialize every cell as a wall
+    WallGrid(int w, int h)
+        : width(w), height(h), stride((w + 63) / 64), words((size_t)stride * h, ~0ULL), bits(words.data()) {}
+
+    // Constructor over external wall bits laid out like an owned grid (stride words per row).
+    // The memory must stay valid and writable while backing is held.
+    WallGrid(int w, int h, uint64_t *externalBits, std::shared_ptr<void> owner)
+        : width(w), height(h), stride((w + 63) / 64), bits(externalBits), backing(std::move(owner)) {}
+
+    // Copies always own their wall bits
+    WallGrid(const WallGrid &other)
+        : width(other.width), height(other.height), stride(other.stride),
+          words(other.bits, other.bits + (size_t)other.stride * other.height), bits(words.data()) {}
+
+    WallGrid &operator=(const WallGrid &other) {
+        if (this != &other) {
+            WallGrid copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    // Moving keeps the same buffer, owned or external
+    WallGrid(WallGrid &&) = default;
+    WallGrid &operator=(WallGrid &&) = default;
+
+    // Checks if the given coordinates are inside the grid boundaries (one unsigned compare per axis)
+    bool isInside(int x, int y) const {
+        return (unsigned)x < (unsigned)width && (unsigned)y < (unsigned)height;
+    }
+
+    // Returns the wall bit of a cell known to be inside the grid
+    bool get(int x, int y) const {
+        return (bits[(size_t)y * stride + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    // Turns a cell into a wall
+    void setWall(int x, int y) {
+        bits[(size_t)y * stride + (x >> 6)] |= 1ULL << (x & 63);
+    }
+
+    // Carves a cell out of the walls
+    void clearWall(int x, int y) {
+        bits[(size_t)y * stride + (x >> 6)] &= ~(1ULL << (x & 63));
+    }
+
+    // Turns every cell back into a wall, keeping the buffer
+    void fillWalls() {
+        std::fill(bits, bits + (size_t)stride * height, ~0ULL);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+
+    // Number of bytes used by the wall plane
+    size_t byteSize() const { return (size_t)stride * height * sizeof(uint64_t); }
+
+    // Whether the wall bits live outside the grid (e.g. in a mapped file)
+    bool isExternal() const { return words.empty() && bits != nullptr; }
+
+    // Direct access to the packed rows, for whole-row scans
+    const uint64_t *row(int y) const { return &bits[(size_t)y * stride]; }
+
+    // Whole wall plane, stride * height words
+    const uint64_t *data() const { return bits; }
+    uint64_t *data() { return bits; }
+};
+
+// Merged wall rectangles never span more rows than this, so the rectangles that
+// touch a given row are all found within a bounded range of the sorted list
+const int WALL_RECT_MAX_ROWS = 32;
+
+// Axis-aligned block of wall cells, in cell units
+struct WallRect {
+    int x, y, width, height;
+};
+
+// Covers every wall with maximal rectangles: each uncovered wall starts the widest
+// horizontal run it can, which then grows down while the row below is a full run too.
+// Rectangles come out sorted by their top row.
+inline void mergeWallRects(const WallGrid &grid, std::vector<WallRect> &rects) {
+    int width = grid.getWidth(), height = grid.getHeight();
+    rects.clear();
+    WallGrid remaining = grid; // Walls not covered by a rectangle yet
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!remaining.get(x, y)) continue;
+
+            int runEnd = x + 1;
+            while (runEnd < width && remaining.get(runEnd, y)) runEnd++;
+
+            int rowEnd = y + 1;
+            while (rowEnd < height && rowEnd - y < WALL_RECT_MAX_ROWS) {
+                int i = x;
+                while (i < runEnd && remaining.get(i, rowEnd)) i++;
+                if (i < runEnd) break;
+                rowEnd++;
+            }
+
+            for (int j = y; j < rowEnd; j++) {
+                for (int i = x; i < runEnd; i++) remaining.clearWall(i, j);
+            }
+            rects.push_back({x, y, runEnd - x, rowEnd - y});
+            x = runEnd - 1;
+        }
+    }
+}
+
+#endif // WALL_GRID_H
@@ -0,0 +1,296 @@
+#ifndef WALL_KERNELS_H
+#define WALL_KERNELS_H
+
+#include "wall_grid.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Bulk queries over the packed wall plane, a whole word (64 cells) or a whole vector
+// of words at a time instead of one get() per cell. The kernel bodies are written once
+// over WallLanes, a group of 64-bit words: 4 with AVX2 (build with -mavx2), 2 with
+// NEON on arm64, and a single plain word otherwise.
+#if defined(__AVX2__)
+#include <immintrin.h>
+const int WALL_LANES = 4;
+typedef uint64_t WallLanes __attribute__((vector_size(32)));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+const int WALL_LANES = 2;
+typedef uint64_t WallLanes __attribute__((vector_size(16)));
+#else
+const int WALL_LANES = 1;
+typedef uint64_t WallLanes;
+#endif
+
+// Reads WALL_LANES words from any address
+inline WallLanes loadLanes(const uint64_t *words) {
+    WallLanes lanes;
+    memcpy(&lanes, words, sizeof(lanes));
+    return lanes;
+}
+
+inline void storeLanes(uint64_t *words, WallLanes lanes) {
+    memcpy(words, &lanes, sizeof(lanes));
+}
+
+inline WallLanes broadcastLanes(uint64_t word) {
+    return WallLanes{} + word;
+}
+
+inline uint64_t laneAt(WallLanes lanes, int i) {
+#if defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+    return lanes[i];
+#else
+    (void)i;
+    return lanes;
+#endif
+}
+
+// CellLanes: a group of 32-bit lanes, one cell coordinate or per-cell value each (8 with
+// AVX2, 4 with NEON or SSE2, which every x86-64 has, a single word otherwise), for the
+// per-agent work on the grid
+#if defined(__AVX2__)
+const int CELL_LANES = 8;
+typedef uint32_t CellLanes __attribute__((vector_size(32)));
+#define CELL_LANES_VECTOR 1
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(__SSE2__)
+const int CELL_LANES = 4;
+#define CELL_LANES_VECTOR 1
+typedef uint32_t CellLanes __attribute__((vector_size(16)));
+#else
+const int CELL_LANES = 1;
+typedef uint32_t CellLanes;
+#endif
+
+// Wall bit of cell (x, y), 1 outside the grid (negative coordinates wrap to large ones)
+inline uint32_t wallBitAt(const WallGrid &grid, uint32_t x, uint32_t y) {
+    if (x >= (uint32_t)grid.getWidth() || y >= (uint32_t)grid.getHeight()) return 1;
+    return (uint32_t)(grid.row((int)y)[x >> 6] >> (x & 63)) & 1;
+}
+
+#if defined(CELL_LANES_VECTOR)
+// Wall bits of a group of cells. AVX2 gathers the 32-bit halves of the row words that hold
+// them (the grid is little-endian, so bit x of a row is bit x & 31 of half x >> 5); NEON
+// and SSE2 have no gather and read them one lane at a time.
+inline CellLanes wallBitAt(const WallGrid &grid, CellLanes x, CellLanes y) {
+#if defined(__AVX2__)
+    CellLanes width = CellLanes{} + (uint32_t)grid.getWidth(), height = CellLanes{} + (uint32_t)grid.getHeight();
+    CellLanes inside = (CellLanes)((x < width) & (y < height));
+    CellLanes half = inside & (y * (uint32_t)(2 * grid.getStride()) + (x >> 5)); // Cell 0 outside, a valid address
+    CellLanes words = (CellLanes)_mm256_i32gather_epi32((const int *)grid.data(), (__m256i)half, 4);
+    return ((words >> (x & 31)) & 1) | (~inside & 1);
+#else
+    CellLanes bits = {};
+    for (int i = 0; i < CELL_LANES; i++) bits[i] = wallBitAt(grid, x[i], y[i]);
+    return bits;
+#endif
+}
+#endif
+
+// Number of 1 bits in each lane
+inline WallLanes lanePopcounts(WallLanes lanes) {
+#if defined(__AVX2__)
+    // Nibble lookup table, then byte sums per lane
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i bits = (__m256i)lanes;
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(bits, nibble)),
+                                     _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(bits, 4), nibble)));
+    return (WallLanes)_mm256_sad_epu8(counts, _mm256_setzero_si256());
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return (WallLanes)vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8((uint8x16_t)lanes))));
+#else
+    return (WallLanes)__builtin_popcountll(lanes);
+#endif
+}
+
+inline uint64_t sumLanes(WallLanes lanes) {
+    uint64_t sum = 0;
+    for (int i = 0; i < WALL_LANES; i++) sum += laneAt(lanes, i);
+    return sum;
+}
+
+// Mask of the cells of the last word of a row that are inside the grid
+inline uint64_t lastWordMask(int width) {
+    return (width & 63) ? (1ULL << (width & 63)) - 1 : ~0ULL;
+}
+
+// Number of 1 bits in count words
+inline size_t popcountWords(const uint64_t *words, size_t count) {
+    WallLanes sums = WallLanes{};
+    size_t i = 0;
+    for (; i + WALL_LANES <= count; i += WALL_LANES) sums += lanePopcounts(loadLanes(words + i));
+    size_t total = sumLanes(sums);
+    for (; i < count; i++) total += __builtin_popcountll(words[i]);
+    return total;
+}
+
+// Number of walls in row y, padding excluded
+inline size_t countWallsInRow(const WallGrid &grid, int y) {
+    const uint64_t *row = grid.row(y);
+    int stride = grid.getStride();
+    return popcountWords(row, stride - 1) + __builtin_popcountll(row[stride - 1] & lastWordMask(grid.getWidth()));
+}
+
+inline size_t countWalls(const WallGrid &grid) {
+    size_t walls = 0;
+    for (int y = 0; y < grid.getHeight(); y++) walls += countWallsInRow(grid, y);
+    return walls;
+}
+
+// Shifted-AND neighbor masks: counts, for every cell of a group of words, how many of
+// its four neighbors are open. The count comes out bit-sliced over three masks (ones,
+// twos and fours hold bits 0, 1 and 2 of it) so a whole group of 64-cell words is
+// counted with a handful of logic ops. previous and next are the words left and right
+// of the group, above and below the same words of the adjacent rows.
+template <class Lanes>
+inline void countOpenNeighbors(Lanes above, Lanes row, Lanes below, Lanes previous, Lanes next,
+                               Lanes &ones, Lanes &twos, Lanes &fours) {
+    Lanes up = ~above, down = ~below;
+    Lanes left = (~row << 1) | (~previous >> 63);   // Bit x of the row is cell x, so x - 1 is one bit lower
+    Lanes right = (~row >> 1) | (~next << 63);
+    // Adds the four 1-bit masks (carry-save)
+    Lanes sum1 = up ^ down, carry1 = up & down;
+    Lanes sum2 = left ^ right, carry2 = left & right;
+    Lanes carry3 = sum1 & sum2;
+    ones = sum1 ^ sum2;
+    twos = carry1 ^ carry2 ^ carry3;
+    fours = carry1 & carry2;                        // carry3 is only set when neither of the others is
+}
+
+// Writes pick(open, ones, twos, fours) for every word of a row into out and returns how
+// many bits are set in it, padding excluded. open is the mask of open cells and the
+// others are the bit-sliced open neighbor counts of countOpenNeighbors. above and below
+// are the adjacent rows, nullptr past the edges of the grid (which count as walls),
+// and pick must accept both uint64_t and WallLanes.
+template <class Pick>
+inline size_t maskRowByOpenNeighbors(const uint64_t *above, const uint64_t *row, const uint64_t *below, int stride,
+                                     int width, uint64_t *out, Pick pick) {
+    const uint64_t wall = ~0ULL;
+    size_t total = 0;
+
+    // Words with both horizontal neighbors in the row, a group at a time
+    int i = 1;
+    if (WALL_LANES > 1) {
+        WallLanes walls = broadcastLanes(wall), sums = WallLanes{};
+        for (; i + WALL_LANES < stride; i += WALL_LANES) {
+            WallLanes ones, twos, fours;
+            WallLanes current = loadLanes(row + i);
+            countOpenNeighbors(above ? loadLanes(above + i) : walls, current, below ? loadLanes(below + i) : walls,
+                               loadLanes(row + i - 1), loadLanes(row + i + 1), ones, twos, fours);
+            WallLanes picked = pick(~current, ones, twos, fours);
+            storeLanes(out + i, picked);
+            sums += lanePopcounts(picked);
+        }
+        total = sumLanes(sums);
+    }
+
+    // The first word, the last one and what the groups left over, one at a time
+    auto single = [&](int w) {
+        uint64_t ones, twos, fours;
+        countOpenNeighbors(above ? above[w] : wall, row[w], below ? below[w] : wall, w > 0 ? row[w - 1] : wall,
+                           w + 1 < stride ? row[w + 1] : wall, ones, twos, fours);
+        out[w] = pick(~row[w], ones, twos, fours);
+        if (w == stride - 1) out[w] &= lastWordMask(width);
+        total += __builtin_popcountll(out[w]);
+    };
+    single(0);
+    for (; i < stride; i++) single(i);
+    return total;
+}
+
+// Adds the open cells of a row, padding excluded, to counts[n] by their number n of open
+// neighbors. One neighbor count per word gives all five classes, so a grid is classified
+// in a single pass (above and below as for maskRowByOpenNeighbors).
+inline void countRowByOpenNeighbors(const uint64_t *above, const uint64_t *row, const uint64_t *below, int stride,
+                                    int width, size_t counts[5]) {
+    const uint64_t wall = ~0ULL;
+
+    // Words with both horizontal neighbors in the row, a group at a time
+    int i = 1;
+    if (WALL_LANES > 1) {
+        WallLanes walls = broadcastLanes(wall), sums[5] = {};
+        for (; i + WALL_LANES < stride; i += WALL_LANES) {
+            WallLanes ones, twos, fours;
+            WallLanes current = loadLanes(row + i), open = ~current;
+            countOpenNeighbors(above ? loadLanes(above + i) : walls, current, below ? loadLanes(below + i) : walls,
+                               loadLanes(row + i - 1), loadLanes(row + i + 1), ones, twos, fours);
+            sums[0] += lanePopcounts(open & ~ones & ~twos & ~fours);
+            sums[1] += lanePopcounts(open & ones & ~twos);
+            sums[2] += lanePopcounts(open & ~ones & twos);
+            sums[3] += lanePopcounts(open & ones & twos);
+            sums[4] += lanePopcounts(open & fours);
+        }
+        for (int n = 0; n < 5; n++) counts[n] += sumLanes(sums[n]);
+    }
+
+    // The first word, the last one and what the groups left over, one at a time
+    auto single = [&](int w) {
+        uint64_t ones, twos, fours;
+        countOpenNeighbors(above ? above[w] : wall, row[w], below ? below[w] : wall, w > 0 ? row[w - 1] : wall,
+                           w + 1 < stride ? row[w + 1] : wall, ones, twos, fours);
+        uint64_t open = ~row[w] & (w == stride - 1 ? lastWordMask(width) : ~0ULL);
+        counts[0] += __builtin_popcountll(open & ~ones & ~twos & ~fours);
+        counts[1] += __builtin_popcountll(open & ones & ~twos);
+        counts[2] += __builtin_popcountll(open & ~ones & twos);
+        counts[3] += __builtin_popcountll(open & ones & twos);
+        counts[4] += __builtin_popcountll(open & fours);
+    };
+    single(0);
+    for (; i < stride; i++) single(i);
+}
+
+// Dead ends of a row (open cells with exactly one open neighbor) into out, returns how many
+inline size_t deadEndsInRow(const WallGrid &grid, int y, uint64_t *out) {
+    return maskRowByOpenNeighbors(y > 0 ? grid.row(y - 1) : nullptr, grid.row(y),
+                                  y + 1 < grid.getHeight() ? grid.row(y + 1) : nullptr, grid.getStride(),
+                                  grid.getWidth(), out, [](auto open, auto ones, auto twos, auto fours) {
+                                      return open & ones & ~twos & ~fours;
+                                  });
+}
+
+inline size_t countDeadEnds(const WallGrid &grid) {
+    std::vector<uint64_t> mask(grid.getStride());
+    size_t deadEnds = 0;
+    for (int y = 0; y < grid.getHeight(); y++) deadEnds += deadEndsInRow(grid, y, mask.data());
+    return deadEnds;
+}
+
+// Halves the wall bits of each lane into its low 32 bits, as a row of the maze lattice
+// (see reduceLatticeRows): bit 2k of the result is bit 4k, bit 2k + 1 the AND of bits
+// 4k + 1 and 4k + 3. Neither reaches into the next lane.
+template <class Lanes>
+inline Lanes halveLatticeBits(Lanes x) {
+    x = (x & 0x1111111111111111ULL) | (x & (x >> 2) & 0x2222222222222222ULL);
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return x;
+}
+
+// One row of downsampleWalls: bit x of out is bit 2x of the input for even x, and the AND
+// of bits 2x - 1 and 2x + 1 for odd x (open if either cell is). The input is the AND of
+// the rows first and second, the same row twice for an even output row. Words past the
+// end of the input rows count as walls.
+inline void reduceLatticeRows(const uint64_t *first, const uint64_t *second, int inStride, uint64_t *out,
+                              int outStride) {
+    int i = 0;
+    if (WALL_LANES > 1) {
+        // A group of input words gives half as many output words
+        for (; 2 * i + WALL_LANES <= inStride && i + WALL_LANES / 2 <= outStride; i += WALL_LANES / 2) {
+            WallLanes words = loadLanes(first + 2 * i) & loadLanes(second + 2 * i);
+            WallLanes halves = halveLatticeBits(words);
+            for (int j = 0; j < WALL_LANES / 2; j++) out[i + j] = laneAt(halves, 2 * j) | (laneAt(halves, 2 * j + 1) << 32);
+        }
+    }
+    for (; i < outStride; i++) {
+        uint64_t low = (2 * i < inStride) ? first[2 * i] & second[2 * i] : ~0ULL;
+        uint64_t high = (2 * i + 1 < inStride) ? first[2 * i + 1] & second[2 * i + 1] : ~0ULL;
+        out[i] = halveLatticeBits(low) | (halveLatticeBits(high) << 32);
+    }
+}
+
+#endif // WALL_KERNELS_H
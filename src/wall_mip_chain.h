@@ -0,0 +1,107 @@
+#ifndef WALL_MIP_CHAIN_H
+#define WALL_MIP_CHAIN_H
+
+#include "raylib.h"
+#include "wall_grid.h"
+#include "wall_kernels.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Side of the next level of the mip chain: half, large enough for the last cell of the
+// side (the generators leave it open when the side is even) and odd, so that the lattice
+// of the level ends with a row and a column of walls
+inline int halveLatticeSide(int side) {
+    return (side / 2 + 1) | 1;
+}
+
+// Halves a maze on its lattice, where the rooms are the cells with two odd coordinates,
+// the pillars the cells with two even ones and the passages between rooms the others.
+// Each room of the result stands for 2x2 rooms of the maze, and the passage between two
+// rooms of the result is open if any passage between the rooms they stand for is. In
+// cells, result (x, y) is open if any of the cells (2x + dx, 2y + dy) is, with dx = 0 for
+// even x and -1 or 1 for odd x (the same for dy). Walls stay walls and passages stay
+// passages, so the result is connected wherever the maze was, level after level.
+inline WallGrid downsampleWalls(const WallGrid &grid) {
+    WallGrid half(halveLatticeSide(grid.getWidth()), halveLatticeSide(grid.getHeight()));
+    int height = grid.getHeight();
+    for (int y = 0; y < half.getHeight(); y++) {
+        // Rows past the end are walls: the row of the result stays all walls without any
+        int first = (y & 1) ? 2 * y - 1 : 2 * y, second = (y & 1) ? 2 * y + 1 : 2 * y;
+        if (first >= height) break;
+        if (second >= height) second = first;
+        uint64_t *row = half.data() + (size_t)y * half.getStride();
+        reduceLatticeRows(grid.row(first), grid.row(second), grid.getStride(), row, half.getStride());
+        row[half.getStride() - 1] |= ~lastWordMask(half.getWidth()); // The padding past the level's last cell
+    }
+    return half;
+}
+
+// Draws the walls of grid inside the cell range [x0, x1) x [y0, y1), one rectangle per
+// horizontal run. Cell (x, y) covers cellWidth x cellHeight pixels from origin.
+inline void drawWallRuns(const WallGrid &grid, Vector2 origin, float cellWidth, float cellHeight, Color color,
+                         int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        int x = x0;
+        while (x < x1) {
+            if (!grid.get(x, y)) {
+                x++;
+                continue;
+            }
+            int runStart = x;
+            while (x < x1 && grid.get(x, y)) x++;
+            DrawRectangleRec({origin.x + runStart * cellWidth, origin.y + y * cellHeight, (x - runStart) * cellWidth,
+                              cellHeight}, color);
+        }
+    }
+}
+
+// WallMipChain class definition
+// Successively halved copies of a wall plane, built once after generation. Level k
+// has cells 2^k times larger than the maze (level 0 is the maze itself and is not
+// stored), so a zoomed-out view or a minimap draws the level whose cells are about
+// a pixel and costs the same at any maze size.
+class WallMipChain {
+private:
+    std::vector<WallGrid> levels;        // levels[k - 1] is level k, down to 3x3 cells or less
+
+public:
+    // Builds every level from the maze's walls, replacing the previous chain
+    void build(const WallGrid &grid) {
+        levels.clear();
+        const WallGrid *previous = &grid;
+        while (previous->getWidth() > 3 || previous->getHeight() > 3) { // 3 cells is a room between two walls
+            levels.push_back(downsampleWalls(*previous));
+            previous = &levels.back();
+        }
+    }
+
+    // Bytes taken by the levels. A level holds a quarter of the cells of the one before, but its
+    // rows are padded to whole words, and below 64 cells wide a row costs a word whatever its
+    // width: the chain takes more than the third of the maze's plane its cells alone would, from
+    // about 0.35 of it for a 4097x4097 maze to more than the whole plane for a 64x36 one.
+    size_t byteSize() const {
+        size_t bytes = 0;
+        for (const WallGrid &level : levels) bytes += level.byteSize();
+        return bytes;
+    }
+
+    // Number of levels, the maze itself included
+    int levelCount() const { return (int)levels.size() + 1; }
+
+    // Level k >= 1
+    const WallGrid &level(int k) const { return levels[k - 1]; }
+
+    // Where level k is drawn from, in maze cells on both axes, so that its cells are centered
+    // on the maze cells they stand for: halving on the lattice keeps centers, not corners
+    static float levelOrigin(int k) { return 0.5f - (float)(1 << (k - 1)); }
+
+    // Finest level whose cells are at least a pixel wide, given how many maze cells a pixel spans
+    int levelFor(float cellsPerPixel) const {
+        int k = 0;
+        while (k + 1 < levelCount() && (float)(1 << k) < cellsPerPixel) k++;
+        return k;
+    }
+};
+
+#endif // WALL_MIP_CHAIN_H
@@ -0,0 +1,79 @@
+// Mip chain test
+// Checks that every level of the wall mip chain is the maze halved on its lattice: the
+// packed kernel against the rule cell by cell, and the first levels still open and
+// connected to the start for every generator and for even and odd maze sides.
+//
+// Usage: wall_mip_chain_test, exits with 1 if a check fails
+
+#include "wall_mip_chain.h"
+#include "distance_field.h"
+#include "maze_generators.h"
+#include "rng.h"
+#include <cstdio>
+
+static int failures = 0;
+
+static void check(bool condition, const char *what, const char *generator, int width, int height, int level) {
+    if (condition) return;
+    printf("FAIL %s: %s maze %dx%d, level %d\n", what, generator, width, height, level);
+    failures++;
+}
+
+// The halving rule one cell at a time, cells outside the grid being walls
+static bool referenceWall(const WallGrid &grid, int x, int y) {
+    for (int dy = (y & 1) ? -1 : 0; dy <= ((y & 1) ? 1 : 0); dy += 2) {
+        for (int dx = (x & 1) ? -1 : 0; dx <= ((x & 1) ? 1 : 0); dx += 2) {
+            int cx = 2 * x + dx, cy = 2 * y + dy;
+            if (grid.isInside(cx, cy) && !grid.get(cx, cy)) return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    // Sides around the word and vector group sizes, even and odd like the game's mazes
+    const int sides[][2] = {{64, 36}, {65, 37}, {38, 21}, {257, 129}, {600, 334}};
+    for (int i = 0; i < MAZE_ALGORITHM_COUNT; i++) {
+        const MazeGeneratorEntry &entry = getMazeGenerators()[i];
+        for (const int *side : sides) {
+            int width = side[0], height = side[1];
+            WallGrid grid(width, height);
+            Rng rng((uint64_t)(i * 31 + width));
+            entry.create()->generate(grid, rng);
+            grid.clearWall(width - 2, height - 2); // The exit, as Maze carves it
+
+            WallMipChain chain;
+            chain.build(grid);
+            const WallGrid *finer = &grid;
+            for (int k = 1; k < chain.levelCount(); k++) {
+                const WallGrid &level = chain.level(k);
+                bool same = level.getWidth() == halveLatticeSide(finer->getWidth()) &&
+                            level.getHeight() == halveLatticeSide(finer->getHeight());
+                for (int y = 0; same && y < level.getHeight(); y++) {
+                    for (int x = 0; x < level.getWidth(); x++) same = same && level.get(x, y) == referenceWall(*finer, x, y);
+                }
+                check(same, "level differs from the halving rule", entry.name, width, height, k);
+                finer = &level;
+            }
+
+            // The first levels keep corridors, all of them reachable from the start
+            for (int k = 1; k <= 2 && k < chain.levelCount(); k++) {
+                const WallGrid &level = chain.level(k);
+                DistanceField fromStart;
+                fromStart.build(level, 1, 1);
+                int open = 0, cutOff = 0;
+                for (int y = 0; y < level.getHeight(); y++) {
+                    for (int x = 0; x < level.getWidth(); x++) {
+                        if (level.get(x, y)) continue;
+                        open++;
+                        cutOff += fromStart.distance(x, y) == DistanceField::UNREACHABLE;
+                    }
+                }
+                check(open > level.getWidth() * level.getHeight() / 4, "too few open cells", entry.name, width, height, k);
+                check(cutOff == 0, "open cells cut off from the start", entry.name, width, height, k);
+            }
+        }
+    }
+    if (failures == 0) printf("wall_mip_chain_test: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}